@@ -0,0 +1,479 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cycle.hpp>
+#include <cycle_catalogue.hpp>
+#include <cycle_database.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <sampling.hpp>
+#include <transition_matrix.hpp>
+
+using namespace std;
+using namespace chrono;
+
+/// @brief Command line options of the benchmark runner.
+struct BenchmarkOptions
+{
+    /// @brief Only run benchmarks whose name contains this.
+    string filter;
+
+    /// @brief File the JSON report is written to, empty prints it to stdout after the table.
+    filesystem::path json_path;
+
+    /// @brief Seed of the generated inputs, the same seed always gives the same inputs.
+    uint64_t seed = 1;
+
+    /// @brief Minimum duration of one repetition.
+    milliseconds min_time { 100 };
+
+    /// @brief Number of timed repetitions, the fastest one is reported.
+    size_t repetitions = 3;
+};
+
+/// @brief Outcome of one benchmark for one board size.
+struct BenchmarkResult
+{
+    string name;
+    size_t size;
+    uint64_t operations;
+    double ns_per_op;
+    double states_per_second;
+
+    /// @brief "passed" or "failed" when the benchmark has a differential check against a reference, empty otherwise.
+    string check;
+};
+
+/// @brief Keeps results alive so the optimizer can not drop the measured work.
+volatile uint64_t sink;
+
+/// @brief Time an operation over all inputs until min_time has passed.
+/// @param operation Runs once for input i and returns the number of board states it processed.
+BenchmarkResult measure(
+    const BenchmarkOptions &options,
+    string name,
+    size_t size,
+    size_t input_count,
+    const function<uint64_t(size_t)> &operation)
+{
+    BenchmarkResult result { std::move(name), size, 0, 0, 0, {} };
+
+    // One untimed pass warms up caches and lookup tables.
+    for (size_t i = 0; i < input_count; ++i)
+        sink = sink + operation(i);
+
+    double best_ns_per_op = numeric_limits<double>::infinity();
+    for (size_t repetition = 0; repetition < max<size_t>(options.repetitions, 1); ++repetition)
+    {
+        uint64_t operations = 0, states = 0;
+        const auto start = steady_clock::now();
+        auto elapsed = steady_clock::duration::zero();
+
+        while (elapsed < options.min_time)
+        {
+            for (size_t i = 0; i < input_count; ++i)
+                states += operation(i);
+            operations += input_count;
+            elapsed = steady_clock::now() - start;
+        }
+
+        const double ns = static_cast<double>(duration_cast<nanoseconds>(elapsed).count());
+        if (ns / operations < best_ns_per_op)
+        {
+            best_ns_per_op = ns / operations;
+            result.operations = operations;
+            result.ns_per_op = best_ns_per_op;
+            result.states_per_second = 1e9 * static_cast<double>(states) / ns;
+        }
+    }
+
+    return result;
+}
+
+/// @brief Fixed-seed boards of size N, half of them uniform and half sparse so that the
+/// cycle searches see both short and long transients.
+template<size_t N>
+vector<Frame<N>> generate_inputs(uint64_t seed, size_t count)
+{
+    CounterRandom random(seed, N);
+    vector<Frame<N>> frames;
+    for (size_t i = 0; i < count; ++i)
+    {
+        absl::uint128 state = random.next128();
+        if (i % 2)
+            state &= random.next128() & random.next128();
+        frames.emplace_back(state & Frame<N>::BoardMask);
+    }
+    return frames;
+}
+
+/// @brief Cycle normalized with the reference frame normalization, mirrors the Cycle constructor.
+template<size_t N>
+Cycle<N> reference_cycle(span<const Frame<N>> frames)
+{
+    Transform min_transform, transform;
+    Frame<N> min_frame = frames[0];
+    for (const auto &frame : frames)
+    {
+        const Frame<N> normalized = frame.normalized_reference(transform);
+        if (normalized < min_frame)
+        {
+            min_frame = normalized;
+            min_transform = transform;
+        }
+    }
+
+    vector<Frame<N>> normalized;
+    for (const auto &frame : frames)
+        normalized.push_back(frame.translated(min_transform.row_offset, min_transform.col_offset).transformed(min_transform.index));
+    sort(normalized.begin(), normalized.end());
+    return Cycle<N>::from_normalized(normalized);
+}
+
+/// @brief Cycle reached after toggling one cell, one board at a time.
+template<size_t N>
+Cycle<N> reference_perturbation(Frame<N> frame, size_t cell)
+{
+    unordered_map<Frame<N>, size_t, typename Frame<N>::Hash> visited_frames;
+    vector<Frame<N>> cycle_frames;
+    frame.toggle(cell);
+    GameOfLife<N> game(frame);
+    return game.find_cycle(visited_frames, cycle_frames);
+}
+
+string check_result(bool passed)
+{
+    return passed ? "passed" : "failed";
+}
+
+template<size_t N>
+void run_size(const BenchmarkOptions &options, vector<BenchmarkResult> &results)
+{
+    const auto selected = [&](string_view name)
+    {
+        return name.find(options.filter) != string_view::npos;
+    };
+
+    const auto inputs = generate_inputs<N>(options.seed, 1024);
+
+    vector<Frame<N>> cycle_frames;
+    unordered_map<Frame<N>, size_t, typename Frame<N>::Hash> visited_frames;
+
+    // Cycles reached from the inputs, these feed the normalization and writer benchmarks.
+    vector<Cycle<N>> cycles;
+    vector<vector<Frame<N>>> raw_cycles;
+    for (const auto &input : inputs)
+    {
+        GameOfLife<N> game(input);
+        cycles.push_back(game.find_cycle(cycle_frames));
+
+        // Walk the cycle from where the search stopped, its frames are not normalized.
+        vector<Frame<N>> frames { game.frame() };
+        for (GameOfLife<N> walker(game.next()); !(walker.frame() == game.frame()); walker.evolve())
+            frames.push_back(walker.frame());
+        raw_cycles.push_back(std::move(frames));
+    }
+
+    if (selected("next"))
+    {
+        bool passed = true;
+        for (const auto &input : inputs)
+            passed = passed && GameOfLife<N>(input).next() == GameOfLife<N>(input).next_reference();
+
+        auto result = measure(options, "next", N, inputs.size(), [&](size_t i)
+        {
+            sink = sink + static_cast<uint64_t>(GameOfLife<N>(inputs[i]).next().get() != 0);
+            return uint64_t(1);
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+
+        results.push_back(measure(options, "next_reference", N, inputs.size(), [&](size_t i)
+        {
+            sink = sink + static_cast<uint64_t>(GameOfLife<N>(inputs[i]).next_reference().get() != 0);
+            return uint64_t(1);
+        }));
+    }
+
+    if (selected("normalized"))
+    {
+        bool passed = true;
+        for (const auto &input : inputs)
+        {
+            Transform fast, reference;
+            passed = passed
+                && input.normalized(fast) == input.normalized_reference(reference)
+                && fast.row_offset == reference.row_offset
+                && fast.col_offset == reference.col_offset
+                && fast.index == reference.index;
+        }
+
+        auto result = measure(options, "normalized", N, inputs.size(), [&](size_t i)
+        {
+            Transform transform;
+            sink = sink + static_cast<uint64_t>(inputs[i].normalized(transform).get() != 0);
+            return uint64_t(1);
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+
+        results.push_back(measure(options, "normalized_reference", N, inputs.size(), [&](size_t i)
+        {
+            Transform transform;
+            sink = sink + static_cast<uint64_t>(inputs[i].normalized_reference(transform).get() != 0);
+            return uint64_t(1);
+        }));
+    }
+
+    if (selected("translated"))
+    {
+        bool passed = true;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const size_t row_offset = i % N, col_offset = (i / N) % N;
+            const Frame<N> translated = inputs[i].translated(row_offset, col_offset);
+            for (size_t row = 0; row < N; ++row)
+            {
+                for (size_t col = 0; col < N; ++col)
+                    passed = passed && translated.get(row, col) == inputs[i].get((row + row_offset) % N, (col + col_offset) % N);
+            }
+        }
+
+        auto result = measure(options, "translated", N, inputs.size(), [&](size_t i)
+        {
+            sink = sink + static_cast<uint64_t>(inputs[i].translated(i % N, (i / N) % N).get() != 0);
+            return uint64_t(1);
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+    }
+
+    if (selected("cycle_normalize"))
+    {
+        bool passed = true;
+        for (const auto &frames : raw_cycles)
+            passed = passed && typename Cycle<N>::Equal()(Cycle<N>(frames), reference_cycle<N>(frames));
+
+        auto result = measure(options, "cycle_normalize", N, raw_cycles.size(), [&](size_t i)
+        {
+            sink = sink + Cycle<N>(raw_cycles[i]).hash();
+            return static_cast<uint64_t>(raw_cycles[i].size());
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+    }
+
+    if (selected("find_cycle"))
+    {
+        bool passed = true;
+        for (const auto &input : inputs)
+        {
+            GameOfLife<N> brent(input), lookup(input);
+            passed = passed && typename Cycle<N>::Equal()(
+                brent.find_cycle(cycle_frames),
+                lookup.find_cycle(visited_frames, cycle_frames));
+        }
+
+        // States are counted as generations stepped.
+        auto result = measure(options, "find_cycle", N, inputs.size(), [&](size_t i)
+        {
+            GameOfLife<N> game(inputs[i]);
+            sink = sink + game.find_cycle(cycle_frames).hash();
+            return static_cast<uint64_t>(game.generation());
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+
+        results.push_back(measure(options, "find_cycle_reference", N, inputs.size(), [&](size_t i)
+        {
+            GameOfLife<N> game(inputs[i]);
+            sink = sink + game.find_cycle(visited_frames, cycle_frames).hash();
+            return static_cast<uint64_t>(game.generation());
+        }));
+    }
+
+    if (selected("perturb_all"))
+    {
+        // Perturbing is slow, a slice of the inputs is enough.
+        const size_t input_count = min<size_t>(inputs.size(), 16);
+
+        bool passed = true;
+        for (size_t i = 0; i < input_count; ++i)
+        {
+            const auto perturbed = GameOfLife<N>::perturb_all(inputs[i]);
+            for (size_t cell = 0; cell < Frame<N>::CellCount; ++cell)
+                passed = passed && typename Cycle<N>::Equal()(perturbed[cell], reference_perturbation(inputs[i], cell));
+        }
+
+        auto result = measure(options, "perturb_all", N, input_count, [&](size_t i)
+        {
+            sink = sink + GameOfLife<N>::perturb_all(inputs[i]).size();
+            return uint64_t(Frame<N>::CellCount);
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+    }
+
+    if (selected("perturb_cycle"))
+    {
+        const size_t input_count = min<size_t>(raw_cycles.size(), 16);
+
+        bool passed = true;
+        for (size_t i = 0; i < input_count; ++i)
+        {
+            const auto sweep = GameOfLife<N>::perturb_cycle(raw_cycles[i]);
+            for (size_t frame_index = 0; frame_index < raw_cycles[i].size(); ++frame_index)
+            {
+                const auto perturbed = GameOfLife<N>::perturb_all(raw_cycles[i][frame_index]);
+                for (size_t cell = 0; cell < Frame<N>::CellCount; ++cell)
+                {
+                    passed = passed && typename Cycle<N>::Equal()(
+                        perturbed[cell], sweep.cycles[sweep.outcomes[frame_index * Frame<N>::CellCount + cell]]);
+                }
+            }
+        }
+
+        // States are counted as perturbations covered, simulated or not.
+        auto result = measure(options, "perturb_cycle", N, input_count, [&](size_t i)
+        {
+            return static_cast<uint64_t>(GameOfLife<N>::perturb_cycle(raw_cycles[i]).outcomes.size());
+        });
+        result.check = check_result(passed);
+        results.push_back(result);
+    }
+
+    if (selected("write"))
+    {
+        vector<Cycle<N>> sorted = cycles;
+        sort(sorted.begin(), sorted.end(), typename Cycle<N>::Less());
+        sorted.erase(unique(sorted.begin(), sorted.end(), typename Cycle<N>::Equal()), sorted.end());
+
+        // The matrix perturbs every frame of every cycle, keep it to a few dozen cycles.
+        sorted.resize(min<size_t>(sorted.size(), 32));
+
+        CycleCatalogue<N> catalogue(sorted.size());
+        for (const auto &cycle : sorted)
+            catalogue.insert(cycle);
+
+        const auto directory = filesystem::temp_directory_path() / ("golc-benchmarks-" + to_string(N));
+        filesystem::create_directories(directory);
+        const auto database_path = directory / "cycles.db";
+
+        // States are counted as frames written.
+        const uint64_t frame_count = catalogue.frame_count();
+
+        results.push_back(measure(options, "write_cycle_database", N, 1, [&](size_t)
+        {
+            write_cycle_database(database_path, catalogue);
+            return frame_count;
+        }));
+
+        const CycleDatabase<N> database(database_path);
+        results.push_back(measure(options, "write_cycle_text", N, 1, [&](size_t)
+        {
+            ostringstream os;
+            write_cycle_text(os, database);
+            sink = sink + os.tellp();
+            return frame_count;
+        }));
+
+        const TransitionMatrix<N> matrix(catalogue);
+        results.push_back(measure(options, "write_matrix_text", N, 1, [&](size_t)
+        {
+            ostringstream os;
+            matrix.write_text(os);
+            sink = sink + os.tellp();
+            return frame_count;
+        }));
+
+        filesystem::remove_all(directory);
+    }
+}
+
+void write_json(ostream &os, const BenchmarkOptions &options, const vector<BenchmarkResult> &results)
+{
+    os << "{\n";
+    os << "  \"seed\": " << options.seed << ",\n";
+#if defined(__AVX2__)
+    os << "  \"avx2\": true,\n";
+#else
+    os << "  \"avx2\": false,\n";
+#endif
+    os << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const auto &result = results[i];
+        os << "    { \"name\": \"" << result.name << "\", \"size\": " << result.size
+           << ", \"operations\": " << result.operations
+           << ", \"ns_per_op\": " << result.ns_per_op
+           << ", \"states_per_second\": " << result.states_per_second
+           << ", \"check\": " << (result.check.empty() ? "null" : '"' + result.check + '"') << " }"
+           << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+/// @brief Benchmarks the hot kernels for every board size from 3x3 to 11x11. Every kernel that has a
+/// reference implementation is checked against it on the same fixed-seed inputs first.
+/// Usage: GoLCBenchmarks [--filter name] [--json path] [--seed n] [--min-time ms] [--repetitions n]
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        const string_view flag = argv[i];
+        const string value = argv[i + 1];
+
+        if ("--filter" == flag)
+            options.filter = value;
+        else if ("--json" == flag)
+            options.json_path = value;
+        else if ("--seed" == flag)
+            options.seed = stoull(value);
+        else if ("--min-time" == flag)
+            options.min_time = milliseconds(stoull(value));
+        else if ("--repetitions" == flag)
+            options.repetitions = stoull(value);
+        else
+        {
+            cerr << "Unknown option " << flag << '\n';
+            return 2;
+        }
+    }
+
+    vector<BenchmarkResult> results;
+    [&]<size_t... Sizes>(index_sequence<Sizes...>)
+    {
+        (run_size<Sizes + 3>(options, results), ...);
+    }(make_index_sequence<9>());
+
+    bool passed = true;
+    for (const auto &result : results)
+    {
+        cout << result.size << 'x' << result.size << ' ' << result.name
+             << ": " << result.ns_per_op << " ns/op, " << result.states_per_second << " states/s"
+             << (result.check.empty() ? "" : ", check " + result.check) << '\n';
+        passed = passed && "failed" != result.check;
+    }
+
+    if (options.json_path.empty())
+        write_json(cout, options, results);
+    else
+    {
+        ofstream os(options.json_path);
+        write_json(os, options, results);
+    }
+
+    // A failed differential check is a correctness regression, not a slowdown.
+    return passed ? 0 : 1;
+}
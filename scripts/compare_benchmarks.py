@@ -0,0 +1,38 @@
+import json
+import sys
+
+# Usage: python compare_benchmarks.py baseline.json current.json [threshold]
+# Prints the speed ratio of every benchmark present in both reports and exits with 1 when
+# any benchmark got slower than the threshold (default 1.1 = 10%) or failed its check.
+
+def load(path):
+  with open(path) as f:
+    report = json.load(f)
+  return {(b['name'], b['size']): b for b in report['benchmarks']}
+
+def main():
+  baseline = load(sys.argv[1])
+  current = load(sys.argv[2])
+  threshold = float(sys.argv[3]) if len(sys.argv) > 3 else 1.1
+
+  regressed = False
+  for key in sorted(current, key=lambda k: (k[1], k[0])):
+    result = current[key]
+    name, size = key
+    if result['check'] == 'failed':
+      print(f'{size}x{size} {name}: check failed')
+      regressed = True
+    if key not in baseline:
+      continue
+
+    ratio = result['ns_per_op'] / baseline[key]['ns_per_op']
+    marker = ''
+    if ratio > threshold:
+      marker = '  <-- slower'
+      regressed = True
+    print(f'{size}x{size} {name}: {baseline[key]["ns_per_op"]:.1f} -> {result["ns_per_op"]:.1f} ns/op ({ratio:.2f}x){marker}')
+
+  sys.exit(1 if regressed else 0)
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,40 @@
+#!/usr/bin/env bash
+# Split the 5x5 enumeration over K local processes, merge their cycle databases and check the result
+# against the merge of one shard covering every state and against a merge of the shards in reverse order.
+# Usage: scripts/test_shards.sh [build directory with GoLC and GoLCMergeShards] [K]
+set -euo pipefail
+
+build_dir=$(realpath "${1:-build}")
+shard_count=${2:-4}
+
+work_dir=$(mktemp -d)
+trap 'rm -rf "$work_dir"' EXIT
+cd "$work_dir"
+
+pids=()
+for ((i = 0; i < shard_count; ++i)); do
+    "$build_dir/GoLC" --shard "$i/$shard_count" > "shard-$i.log" &
+    pids+=($!)
+done
+for pid in "${pids[@]}"; do
+    wait "$pid"
+done
+
+shards=()
+for ((i = 0; i < shard_count; ++i)); do
+    shards+=("5x5-shard-$i-of-$shard_count.db")
+done
+"$build_dir/GoLCMergeShards" merged.db "${shards[@]}"
+
+reversed=()
+for ((i = shard_count - 1; i >= 0; --i)); do
+    reversed+=("${shards[$i]}")
+done
+"$build_dir/GoLCMergeShards" reversed.db "${reversed[@]}" > /dev/null
+
+"$build_dir/GoLC" --shard 0/1 > single.log
+"$build_dir/GoLCMergeShards" single.db 5x5-shard-0-of-1.db > /dev/null
+
+cmp merged.db reversed.db
+cmp merged.db single.db
+echo "$shard_count shards merge into the same database as a single run"
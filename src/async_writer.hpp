@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <absl/numeric/int128.h>
+#include <instrumentation.hpp>
+#include <uint256.hpp>
+
+/// @brief Byte buffer that text output is formatted into with std::to_chars instead of streams.
+class OutputBuffer
+{
+
+private:
+
+    std::string m_bytes;
+
+    /// @brief Append a value below 10^19 padded with zeros to 19 digits.
+    void append_padded(uint64_t value)
+    {
+        char digits[19];
+        const auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        const auto length = static_cast<size_t>(end - digits);
+        m_bytes.append(sizeof(digits) - length, '0');
+        m_bytes.append(digits, length);
+    }
+
+public:
+
+    void append(std::string_view text)
+    {
+        m_bytes.append(text);
+    }
+
+    void append(char ch)
+    {
+        m_bytes.push_back(ch);
+    }
+
+    template<class T>
+    requires(std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>)
+    void append(T value)
+    {
+        char digits[24];
+        const auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+        m_bytes.append(digits, end);
+    }
+
+    /// @brief Append in decimal like the absl::uint128 stream operator does.
+    void append(absl::uint128 value)
+    {
+        // Split off 19 decimal digits at a time, the largest power of ten that fits a word.
+        constexpr uint64_t Chunk = 10'000'000'000'000'000'000ull;
+
+        if (0 == absl::Uint128High64(value))
+        {
+            append(absl::Uint128Low64(value));
+            return;
+        }
+
+        const absl::uint128 high = value / Chunk;
+        const auto low = static_cast<uint64_t>(value % Chunk);
+        append(high);
+        append_padded(low);
+    }
+
+    void append(const uint256 &value)
+    {
+        constexpr uint64_t Chunk = 10'000'000'000'000'000'000ull;
+
+        const auto [quotient, remainder] = value.divide(Chunk);
+        if (!quotient)
+        {
+            append(remainder);
+            return;
+        }
+        append(quotient);
+        append_padded(remainder);
+    }
+
+    [[nodiscard]] const char* data() const
+    {
+        return m_bytes.data();
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        return m_bytes.size();
+    }
+
+    [[nodiscard]] std::string_view view() const
+    {
+        return m_bytes;
+    }
+
+    void clear()
+    {
+        m_bytes.clear();
+    }
+};
+
+/// @brief Counters of an asynchronous writer, final once it is closed.
+struct WriterStats
+{
+    uint64_t items = 0;
+
+    uint64_t bytes = 0;
+
+    /// @brief Number of write calls issued to the file.
+    uint64_t flushes = 0;
+
+    /// @brief Largest number of items that waited in the queue at once.
+    size_t max_queue_depth = 0;
+
+    /// @brief Time producers spent blocked on a full queue.
+    std::chrono::milliseconds producer_wait { 0 };
+
+    /// @brief Time the writer thread spent formatting.
+    std::chrono::milliseconds format_time { 0 };
+
+    /// @brief Time the writer thread spent in write calls.
+    std::chrono::milliseconds write_time { 0 };
+};
+
+/// @brief Streams items into a file from a dedicated writer thread. Producers push items into a
+/// bounded queue and block while it is full, the writer thread formats them into one large buffer
+/// and hands the buffer to the file in big sequential writes. Compute can therefore carry on with
+/// the next stage while the output of the previous one is still being formatted and written.
+/// @tparam Item what producers hand over, usually an id the formatter looks up.
+template<class Item>
+class AsyncWriter
+{
+
+public:
+
+    using Formatter = std::function<void(const Item&, OutputBuffer&)>;
+
+private:
+
+    Formatter m_formatter;
+
+    size_t m_queue_capacity;
+
+    size_t m_buffer_bytes;
+
+    std::filesystem::path m_path;
+
+    int m_fd;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_not_empty;
+
+    std::condition_variable m_not_full;
+
+    std::deque<Item> m_queue;
+
+    bool m_closed = false;
+
+    WriterStats m_stats;
+
+    std::exception_ptr m_error;
+
+    std::thread m_thread;
+
+    void flush(OutputBuffer &buffer)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        size_t written = 0;
+        while (written < buffer.size())
+        {
+            const ssize_t result = ::write(m_fd, buffer.data() + written, buffer.size() - written);
+            if (result < 0)
+                throw std::runtime_error("Could not write file: " + m_path.string());
+            written += static_cast<size_t>(result);
+        }
+
+        m_stats.bytes += buffer.size();
+        ++m_stats.flushes;
+        m_stats.write_time += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        buffer.clear();
+    }
+
+    void run()
+    {
+        const instrumentation::Span span("writer", "output");
+        OutputBuffer buffer;
+        std::deque<Item> batch;
+
+        try
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_not_empty.wait(lock, [&] { return m_closed || !m_queue.empty(); });
+                    if (m_queue.empty())
+                        break;
+
+                    // Take everything at once, producers blocked on a full queue can refill it meanwhile.
+                    batch.swap(m_queue);
+                }
+                m_not_full.notify_all();
+
+                const auto start = std::chrono::steady_clock::now();
+                for (const auto &item : batch)
+                {
+                    m_formatter(item, buffer);
+                    if (buffer.size() >= m_buffer_bytes)
+                        flush(buffer);
+                }
+                m_stats.items += batch.size();
+                m_stats.format_time += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                batch.clear();
+            }
+
+            flush(buffer);
+        }
+        catch (...)
+        {
+            std::lock_guard lock(m_mutex);
+            m_error = std::current_exception();
+            m_closed = true;
+            m_queue.clear();
+            m_not_full.notify_all();
+        }
+    }
+
+public:
+
+    /// @param path File to create or truncate.
+    /// @param formatter Appends the text of one item to the buffer, runs on the writer thread.
+    /// @param queue_capacity Number of items that may wait before push blocks.
+    /// @param buffer_bytes Size at which the buffer is written out.
+    AsyncWriter(
+        const std::filesystem::path &path,
+        Formatter formatter,
+        size_t queue_capacity = 4096,
+        size_t buffer_bytes = 4 << 20)
+    : m_formatter(std::move(formatter))
+    , m_queue_capacity(std::max<size_t>(queue_capacity, 1))
+    , m_buffer_bytes(buffer_bytes)
+    , m_path(path)
+    , m_fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644))
+    {
+        if (m_fd < 0)
+            throw std::runtime_error("Could not open file: " + path.string());
+        m_thread = std::thread([this] { run(); });
+    }
+
+    AsyncWriter(const AsyncWriter&) = delete;
+    AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+    ~AsyncWriter()
+    {
+        try
+        {
+            (void)close();
+        }
+        catch (...)
+        {
+            // Errors surface through close, a destructor can only drop them.
+        }
+    }
+
+    /// @brief Queue an item, blocks while the queue is full. Throws the error of the writer thread
+    /// once it has failed, close throws it again.
+    void push(Item item)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            if (m_queue.size() >= m_queue_capacity)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                m_not_full.wait(lock, [&] { return m_closed || m_queue.size() < m_queue_capacity; });
+                m_stats.producer_wait += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            }
+            if (m_error)
+                std::rethrow_exception(m_error);
+            if (m_closed)
+                throw std::runtime_error("Writer is closed: " + m_path.string());
+
+            m_queue.push_back(std::move(item));
+            m_stats.max_queue_depth = std::max(m_stats.max_queue_depth, m_queue.size());
+        }
+        m_not_empty.notify_one();
+    }
+
+    /// @brief Write out every queued item and close the file.
+    /// @return Final statistics.
+    WriterStats close()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_closed = true;
+        }
+        m_not_empty.notify_one();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+            if (0 != ::close(m_fd) && !m_error)
+                m_error = std::make_exception_ptr(std::runtime_error("Could not close file: " + m_path.string()));
+        }
+
+        if (m_error)
+            std::rethrow_exception(std::exchange(m_error, nullptr));
+        return m_stats;
+    }
+};
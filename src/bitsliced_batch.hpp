@@ -0,0 +1,235 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <types.hpp>
+#include <frame.hpp>
+
+/// @brief Word operations used by the bit-sliced batch, bit k of a word belongs to board k.
+/// @tparam Word word type holding one bit per board.
+template<class Word>
+struct LaneTraits;
+
+template<>
+struct LaneTraits<u64>
+{
+    constexpr static size_t Lanes = 64;
+
+    [[nodiscard]] static u64 zero() { return 0; }
+    [[nodiscard]] static u64 bit_and(u64 a, u64 b) { return a & b; }
+    [[nodiscard]] static u64 bit_or(u64 a, u64 b) { return a | b; }
+    [[nodiscard]] static u64 bit_xor(u64 a, u64 b) { return a ^ b; }
+
+    /// @return ~a & b
+    [[nodiscard]] static u64 bit_andnot(u64 a, u64 b) { return ~a & b; }
+
+    [[nodiscard]] static bool get(u64 word, size_t lane)
+    {
+        return (word >> lane) & 1;
+    }
+
+    /// @brief Copy the lanes out as 64-bit words, lane k lands in bit k % 64 of parts[k / 64].
+    static void store(u64 word, u64 *parts)
+    {
+        parts[0] = word;
+    }
+
+    static void set(u64 &word, size_t lane, bool value)
+    {
+        word = (word & ~(u64(1) << lane)) | (u64(value) << lane);
+    }
+};
+
+#if defined(__AVX2__)
+/// @brief i256 wrapped in a struct, vector attributes are dropped when the bare type is a template argument.
+struct WideWord
+{
+    i256 bits;
+};
+
+template<>
+struct LaneTraits<WideWord>
+{
+    constexpr static size_t Lanes = 256;
+
+    [[nodiscard]] static WideWord zero() { return { _mm256_setzero_si256() }; }
+    [[nodiscard]] static WideWord bit_and(WideWord a, WideWord b) { return { _mm256_and_si256(a.bits, b.bits) }; }
+    [[nodiscard]] static WideWord bit_or(WideWord a, WideWord b) { return { _mm256_or_si256(a.bits, b.bits) }; }
+    [[nodiscard]] static WideWord bit_xor(WideWord a, WideWord b) { return { _mm256_xor_si256(a.bits, b.bits) }; }
+
+    /// @return ~a & b
+    [[nodiscard]] static WideWord bit_andnot(WideWord a, WideWord b) { return { _mm256_andnot_si256(a.bits, b.bits) }; }
+
+    [[nodiscard]] static bool get(WideWord word, size_t lane)
+    {
+        alignas(32) u64 parts[4];
+        _mm256_store_si256(reinterpret_cast<i256*>(parts), word.bits);
+        return LaneTraits<u64>::get(parts[lane / 64], lane % 64);
+    }
+
+    /// @brief Copy the lanes out as 64-bit words, lane k lands in bit k % 64 of parts[k / 64].
+    static void store(WideWord word, u64 *parts)
+    {
+        _mm256_storeu_si256(reinterpret_cast<i256*>(parts), word.bits);
+    }
+
+    static void set(WideWord &word, size_t lane, bool value)
+    {
+        alignas(32) u64 parts[4];
+        _mm256_store_si256(reinterpret_cast<i256*>(parts), word.bits);
+        LaneTraits<u64>::set(parts[lane / 64], lane % 64, value);
+        word.bits = _mm256_load_si256(reinterpret_cast<const i256*>(parts));
+    }
+};
+
+using DefaultLaneWord = WideWord;
+#else
+using DefaultLaneWord = u64;
+#endif
+
+/// @brief Many boards kept in bit-sliced form: one word per cell where lane k belongs to board k.
+/// A step advances every board at once with full-adder logic on whole words.
+/// @tparam Ts size of the board
+/// @tparam Word word type, WideWord advances 256 boards per step with AVX2 and u64 is the portable fallback.
+template<size_t Ts, class Word = DefaultLaneWord>
+class BitslicedBatch
+{
+
+public:
+
+    using Traits = LaneTraits<Word>;
+
+    constexpr static size_t Lanes = Traits::Lanes;
+
+private:
+
+    std::array<Word, Frame<Ts>::CellCount> m_cells;
+
+    [[nodiscard]] constexpr static std::array<std::array<uint8_t, 8>, Frame<Ts>::CellCount> create_neighbour_lut()
+    {
+        std::array<std::array<uint8_t, 8>, Frame<Ts>::CellCount> table{};
+        for (size_t row = 0; row < Ts; ++row)
+        {
+            for (size_t col = 0; col < Ts; ++col)
+            {
+                size_t n = 0;
+                for (size_t i = Ts - 1; i <= Ts + 1; ++i)
+                {
+                    for (size_t j = Ts - 1; j <= Ts + 1; ++j)
+                    {
+                        if (i == Ts && j == Ts)
+                            continue;
+
+                        table[Frame<Ts>::to_index(row, col)][n++] =
+                            static_cast<uint8_t>(Frame<Ts>::to_index((row + i) % Ts, (col + j) % Ts));
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr static std::array<std::array<uint8_t, 8>, Frame<Ts>::CellCount> neighbour_lookup = create_neighbour_lut();
+
+    static void full_add(Word a, Word b, Word c, Word &sum, Word &carry)
+    {
+        const Word partial = Traits::bit_xor(a, b);
+        sum = Traits::bit_xor(partial, c);
+        carry = Traits::bit_or(Traits::bit_and(a, b), Traits::bit_and(partial, c));
+    }
+
+    static void half_add(Word a, Word b, Word &sum, Word &carry)
+    {
+        sum = Traits::bit_xor(a, b);
+        carry = Traits::bit_and(a, b);
+    }
+
+public:
+
+    /// @brief Batch where every board is empty.
+    BitslicedBatch()
+    {
+        m_cells.fill(Traits::zero());
+    }
+
+    /// @brief Batch holding the given frames in lanes [0, frames.size()), the remaining lanes are empty.
+    explicit BitslicedBatch(std::span<const Frame<Ts>> frames)
+    : BitslicedBatch()
+    {
+        load(frames);
+    }
+
+    /// @brief Put frames into lanes [0, frames.size()).
+    void load(std::span<const Frame<Ts>> frames)
+    {
+        for (size_t lane = 0; lane < frames.size() && lane < Lanes; ++lane)
+            set(lane, frames[lane]);
+    }
+
+    /// @brief Copy lanes [0, frames.size()) out into frames.
+    void store(std::span<Frame<Ts>> frames) const
+    {
+        for (size_t lane = 0; lane < frames.size() && lane < Lanes; ++lane)
+            frames[lane] = frame(lane);
+    }
+
+    void set(size_t lane, const Frame<Ts> &frame)
+    {
+        for (size_t i = 0; i < Frame<Ts>::CellCount; ++i)
+            Traits::set(m_cells[i], lane, frame.get(i));
+    }
+
+    [[nodiscard]] Frame<Ts> frame(size_t lane) const
+    {
+        Frame<Ts> frame;
+        for (size_t i = 0; i < Frame<Ts>::CellCount; ++i)
+            frame.set(i, Traits::get(m_cells[i], lane));
+        return frame;
+    }
+
+    /// @return Word of cell i, lane k holds the cell of board k.
+    [[nodiscard]] const Word& cell(size_t i) const
+    {
+        return m_cells[i];
+    }
+
+    /// @return Word where lane k is set if board k differs between the two batches.
+    [[nodiscard]] Word differing_lanes(const BitslicedBatch &other) const
+    {
+        Word differences = Traits::zero();
+        for (size_t i = 0; i < Frame<Ts>::CellCount; ++i)
+            differences = Traits::bit_or(differences, Traits::bit_xor(m_cells[i], other.m_cells[i]));
+        return differences;
+    }
+
+    /// @brief Advance every board in the batch by one generation.
+    void evolve()
+    {
+        std::array<Word, Frame<Ts>::CellCount> next;
+
+        for (size_t i = 0; i < Frame<Ts>::CellCount; ++i)
+        {
+            const auto &n = neighbour_lookup[i];
+
+            Word s0, c0, s1, c1, s2, c2;
+            full_add(m_cells[n[0]], m_cells[n[1]], m_cells[n[2]], s0, c0);
+            full_add(m_cells[n[3]], m_cells[n[4]], m_cells[n[5]], s1, c1);
+            half_add(m_cells[n[6]], m_cells[n[7]], s2, c2);
+
+            Word ones, c3;
+            full_add(s0, s1, s2, ones, c3);
+
+            // Any carry out of the twos column means four or more neighbours.
+            Word t0, c4, twos, c5;
+            full_add(c0, c1, c2, t0, c4);
+            half_add(t0, c3, twos, c5);
+
+            next[i] = Traits::bit_and(
+                Traits::bit_andnot(Traits::bit_or(c4, c5), twos),
+                Traits::bit_or(ones, m_cells[i]));
+        }
+
+        m_cells = next;
+    }
+};
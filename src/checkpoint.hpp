@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+#include <cycle.hpp>
+#include <frame.hpp>
+
+/// @brief Binary helpers shared by every checkpoint. A checkpoint is written to a temporary
+/// file next to the target, synced to disk and renamed over the target, so a crash at any
+/// point leaves either the previous or the new checkpoint intact.
+namespace checkpoint
+{
+    constexpr uint32_t Version = 1;
+
+    template<class T>
+    requires(std::is_trivially_copyable_v<T>)
+    void write_value(std::ostream &os, const T &value)
+    {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<class T>
+    requires(std::is_trivially_copyable_v<T>)
+    [[nodiscard]] T read_value(std::istream &is)
+    {
+        T value;
+        if (!is.read(reinterpret_cast<char*>(&value), sizeof(T)))
+            throw std::runtime_error("Checkpoint is truncated");
+        return value;
+    }
+
+    /// @brief Write the header that identifies the kind of checkpoint and the board size.
+    inline void write_header(std::ostream &os, uint32_t magic, uint32_t board_size)
+    {
+        write_value(os, magic);
+        write_value(os, Version);
+        write_value(os, board_size);
+    }
+
+    /// @brief Read and validate a header written by write_header.
+    inline void read_header(std::istream &is, uint32_t magic, uint32_t board_size)
+    {
+        if (read_value<uint32_t>(is) != magic)
+            throw std::runtime_error("Checkpoint has an unexpected kind");
+        if (read_value<uint32_t>(is) != Version)
+            throw std::runtime_error("Checkpoint has an unsupported version");
+        if (read_value<uint32_t>(is) != board_size)
+            throw std::runtime_error("Checkpoint was written for another board size");
+    }
+
+    template<size_t Ts>
+    void write_cycles(std::ostream &os, std::span<const Cycle<Ts>> cycles)
+    {
+        write_value<uint64_t>(os, cycles.size());
+        for (const auto &cycle : cycles)
+        {
+            write_value<uint32_t>(os, static_cast<uint32_t>(cycle.frames().size()));
+            os.write(reinterpret_cast<const char*>(cycle.frames().data()), cycle.frames().size_bytes());
+        }
+    }
+
+    template<size_t Ts>
+    [[nodiscard]] std::vector<Cycle<Ts>> read_cycles(std::istream &is)
+    {
+        std::vector<Cycle<Ts>> cycles(read_value<uint64_t>(is));
+        std::vector<Frame<Ts>> frames;
+        for (auto &cycle : cycles)
+        {
+            frames.resize(read_value<uint32_t>(is));
+            if (!is.read(reinterpret_cast<char*>(frames.data()), frames.size() * sizeof(Frame<Ts>)))
+                throw std::runtime_error("Checkpoint is truncated");
+            cycle = Cycle<Ts>::from_normalized(frames);
+        }
+        return cycles;
+    }
+
+    /// @brief Replace the file at path with whatever writer produces, atomically.
+    /// @param path Checkpoint file.
+    /// @param writer Callable that serializes the checkpoint into the given stream.
+    inline void write_atomically(const std::filesystem::path &path, const std::function<void(std::ostream&)> &writer)
+    {
+        std::ostringstream buffer(std::ios::binary);
+        writer(buffer);
+        const std::string bytes = buffer.str();
+
+        const std::filesystem::path temporary = path.string() + ".tmp";
+        const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::runtime_error("Could not open checkpoint file: " + temporary.string());
+
+        size_t written = 0;
+        while (written < bytes.size())
+        {
+            const ssize_t result = ::write(fd, bytes.data() + written, bytes.size() - written);
+            if (result < 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Could not write checkpoint file: " + temporary.string());
+            }
+            written += static_cast<size_t>(result);
+        }
+
+        if (0 != ::fsync(fd) || 0 != ::close(fd))
+            throw std::runtime_error("Could not sync checkpoint file: " + temporary.string());
+
+        std::filesystem::rename(temporary, path);
+    }
+
+    /// @brief Open a checkpoint for reading.
+    [[nodiscard]] inline std::ifstream open(const std::filesystem::path &path)
+    {
+        std::ifstream is(path, std::ios::binary);
+        if (!is.is_open())
+            throw std::runtime_error("Could not open checkpoint file: " + path.string());
+        return is;
+    }
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+#include <cycle.hpp>
+#include <instrumentation.hpp>
+
+/// @brief Set of normalized cycles that many threads insert into at once. Cycles are spread over
+/// lock-striped shards by the high bits of their cached hash, each shard is an open-addressing
+/// table of indices into its own cycle vector. An id encodes the shard and the position in it, so
+/// it is stable from insertion on. finalize() numbers all cycles in sorted order, which gives ids
+/// that do not depend on the thread count or on the order of insertion.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class ConcurrentCycleSet
+{
+
+private:
+
+    constexpr static uint32_t Empty = std::numeric_limits<uint32_t>::max();
+
+    struct alignas(64) Shard
+    {
+        mutable std::mutex mutex;
+        std::vector<Cycle<Ts>> cycles;
+        std::vector<uint32_t> slots;
+        size_t mask = 0;
+
+        /// @brief Final id of every cycle, filled by finalize.
+        std::vector<uint32_t> final_ids;
+    };
+
+    size_t m_shard_bits;
+
+    std::unique_ptr<Shard[]> m_shards;
+
+    [[nodiscard]] size_t shard_count() const
+    {
+        return size_t(1) << m_shard_bits;
+    }
+
+    [[nodiscard]] size_t shard_index(size_t hash) const
+    {
+        return m_shard_bits > 0 ? hash >> (std::numeric_limits<size_t>::digits - m_shard_bits) : 0;
+    }
+
+    /// @return Slot holding the cycle or the empty slot where it belongs.
+    [[nodiscard]] static size_t probe(const Shard &shard, const Cycle<Ts> &cycle)
+    {
+        instrumentation::count(instrumentation::Counter::HashLookups);
+
+        size_t slot = cycle.hash() & shard.mask;
+        instrumentation::count(instrumentation::Counter::HashProbes);
+        while (Empty != shard.slots[slot] && !typename Cycle<Ts>::Equal()(shard.cycles[shard.slots[slot]], cycle))
+        {
+            slot = (slot + 1) & shard.mask;
+            instrumentation::count(instrumentation::Counter::HashProbes);
+        }
+        return slot;
+    }
+
+    static void rehash(Shard &shard, size_t slot_count)
+    {
+        shard.slots.assign(slot_count, Empty);
+        shard.mask = slot_count - 1;
+        for (uint32_t local = 0; local < shard.cycles.size(); ++local)
+        {
+            size_t slot = shard.cycles[local].hash() & shard.mask;
+            while (Empty != shard.slots[slot])
+                slot = (slot + 1) & shard.mask;
+            shard.slots[slot] = local;
+        }
+    }
+
+    [[nodiscard]] uint32_t encode(size_t shard, uint32_t local) const
+    {
+        return static_cast<uint32_t>((size_t(local) << m_shard_bits) | shard);
+    }
+
+    [[nodiscard]] std::pair<size_t, uint32_t> decode(uint32_t id) const
+    {
+        return { id & (shard_count() - 1), id >> m_shard_bits };
+    }
+
+public:
+
+    /// @param shard_count Number of independently locked shards, rounded up to a power of two.
+    explicit ConcurrentCycleSet(size_t shard_count = 64)
+    : m_shard_bits(std::bit_width(std::bit_ceil(std::max<size_t>(shard_count, 1))) - 1)
+    , m_shards(std::make_unique<Shard[]>(size_t(1) << m_shard_bits))
+    {
+        for (size_t i = 0; i < this->shard_count(); ++i)
+            rehash(m_shards[i], 16);
+    }
+
+    /// @brief Add a cycle unless an equal cycle is already in the set.
+    /// @return Id of the cycle and whether it was inserted.
+    std::pair<uint32_t, bool> insert(const Cycle<Ts> &cycle)
+    {
+        const size_t index = shard_index(cycle.hash());
+        Shard &shard = m_shards[index];
+        std::lock_guard lock(shard.mutex);
+
+        const size_t slot = probe(shard, cycle);
+        if (Empty != shard.slots[slot])
+            return { encode(index, shard.slots[slot]), false };
+
+        const auto local = static_cast<uint32_t>(shard.cycles.size());
+        shard.cycles.push_back(cycle);
+        shard.slots[slot] = local;
+
+        // Keep the load factor at or below one half.
+        if (2 * shard.cycles.size() > shard.slots.size())
+            rehash(shard, 2 * shard.slots.size());
+
+        return { encode(index, local), true };
+    }
+
+    /// @return Id of an equal cycle or nothing if there is none.
+    [[nodiscard]] std::optional<uint32_t> find(const Cycle<Ts> &cycle) const
+    {
+        const size_t index = shard_index(cycle.hash());
+        const Shard &shard = m_shards[index];
+        std::lock_guard lock(shard.mutex);
+
+        const size_t slot = probe(shard, cycle);
+        if (Empty == shard.slots[slot])
+            return std::nullopt;
+        return encode(index, shard.slots[slot]);
+    }
+
+    [[nodiscard]] bool contains(const Cycle<Ts> &cycle) const
+    {
+        return find(cycle).has_value();
+    }
+
+    [[nodiscard]] Cycle<Ts> cycle(uint32_t id) const
+    {
+        const auto [index, local] = decode(id);
+        std::lock_guard lock(m_shards[index].mutex);
+        return m_shards[index].cycles[local];
+    }
+
+    [[nodiscard]] size_t size() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            std::lock_guard lock(m_shards[i].mutex);
+            total += m_shards[i].cycles.size();
+        }
+        return total;
+    }
+
+    /// @brief Copy of every cycle in no particular order.
+    [[nodiscard]] std::vector<Cycle<Ts>> snapshot() const
+    {
+        std::vector<Cycle<Ts>> cycles;
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            std::lock_guard lock(m_shards[i].mutex);
+            cycles.insert(cycles.end(), m_shards[i].cycles.begin(), m_shards[i].cycles.end());
+        }
+        return cycles;
+    }
+
+    /// @brief Number the cycles in sorted order, must not run concurrently with insert.
+    /// @return Every cycle in sorted order, the index of a cycle is its final id.
+    std::vector<Cycle<Ts>> finalize()
+    {
+        std::vector<std::pair<Cycle<Ts>, uint32_t>> entries;
+        for (size_t i = 0; i < shard_count(); ++i)
+        {
+            for (uint32_t local = 0; local < m_shards[i].cycles.size(); ++local)
+                entries.emplace_back(m_shards[i].cycles[local], encode(i, local));
+        }
+
+        std::sort(entries.begin(), entries.end(), [](const auto &a, const auto &b)
+        {
+            return typename Cycle<Ts>::Less()(a.first, b.first);
+        });
+
+        for (size_t i = 0; i < shard_count(); ++i)
+            m_shards[i].final_ids.assign(m_shards[i].cycles.size(), Empty);
+
+        std::vector<Cycle<Ts>> sorted;
+        sorted.reserve(entries.size());
+        for (auto &[cycle, id] : entries)
+        {
+            const auto [index, local] = decode(id);
+            m_shards[index].final_ids[local] = static_cast<uint32_t>(sorted.size());
+            sorted.push_back(std::move(cycle));
+        }
+        return sorted;
+    }
+
+    /// @return Final id assigned by the last finalize to the cycle with the given id.
+    [[nodiscard]] uint32_t final_id(uint32_t id) const
+    {
+        const auto [index, local] = decode(id);
+        return m_shards[index].final_ids[local];
+    }
+};
@@ -1,43 +1,172 @@
 #pragma once
 
-#include <set>
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_set>
+#include <vector>
 #include <frame.hpp>
 #include "absl/hash/hash.h"
 
-/// @brief 
+/// @brief Normalized cycle, frames are kept sorted in a small inline buffer that spills to
+/// the heap for longer periods. The hash is computed once on construction.
 /// @tparam Ts size of the board 
 template <size_t Ts>
 class Cycle
 {
 
+public:
+
+    /// @brief Number of frames stored without a heap allocation, still lifes and blinkers dominate.
+    constexpr static size_t InlineCapacity = 2;
+
 private:
 
-    std::set<Frame<Ts>> m_frames;
+    std::array<Frame<Ts>, InlineCapacity> m_inline;
+
+    std::unique_ptr<Frame<Ts>[]> m_heap;
+
+    uint32_t m_size;
+
+    size_t m_hash;
+
+    [[nodiscard]] Frame<Ts>* data()
+    {
+        return m_heap ? m_heap.get() : m_inline.data();
+    }
+
+    void allocate(size_t size)
+    {
+        m_size = static_cast<uint32_t>(size);
+        m_heap.reset(size > InlineCapacity ? new Frame<Ts>[size] : nullptr);
+    }
+
+    void compute_hash()
+    {
+        size_t seed = 0;
+        for (const auto& frame : frames())
+        {
+            const typename Frame<Ts>::Hash hasher;
+            seed ^= hasher(frame) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        m_hash = seed;
+    }
 
 public:
 
-    constexpr Cycle()
+    Cycle()
+    : m_size(1)
     {
-        m_frames = std::set<Frame<Ts>> { Frame<Ts>(0) };
+        m_inline[0] = Frame<Ts>(0);
+        compute_hash();
+    }
+
+    explicit Cycle(std::span<const Frame<Ts>> frames)
+    {
+        allocate(frames.size());
+
+        if (frames.empty())
+        {
+            compute_hash();
+            return;
+        }
+
+        const Transform min_transform = normalizing_transform(frames);
+
+        Frame<Ts>* normalized = data();
+        for (size_t i = 0; i < frames.size(); ++i)
+        {
+            normalized[i] = frames[i]
+                .translated(min_transform.row_offset, min_transform.col_offset)
+                .transformed(min_transform.index);
+        }
+        std::sort(normalized, normalized + m_size);
+
+        compute_hash();
     }
 
-    explicit constexpr Cycle(const std::vector<Frame<Ts>> &frames)
+    /// @brief Build a cycle from frames that are already normalized and sorted, e.g. read back from a catalogue.
+    [[nodiscard]] static Cycle from_normalized(std::span<const Frame<Ts>> frames)
     {
-        m_frames = normalize(frames);
+        Cycle cycle;
+        cycle.allocate(frames.size());
+        std::copy(frames.begin(), frames.end(), cycle.data());
+        cycle.compute_hash();
+        return cycle;
     }
 
-    [[nodiscard]] constexpr const std::set<Frame<Ts>>& frames() const
+    Cycle(const Cycle &other)
+    : m_inline(other.m_inline)
     {
-        return m_frames;
+        allocate(other.m_size);
+        std::copy(other.frames().begin(), other.frames().end(), data());
+        m_hash = other.m_hash;
     }
 
-    constexpr static std::set<Frame<Ts>> normalize(const std::vector<Frame<Ts>> &frames)
+    Cycle(Cycle &&other) noexcept
+    : m_inline(other.m_inline)
+    , m_heap(std::move(other.m_heap))
+    , m_size(other.m_size)
+    , m_hash(other.m_hash)
     {
-        if(frames.empty())
-            return {};
+        other.m_size = 0;
+    }
 
+    Cycle& operator=(const Cycle &other)
+    {
+        if (this != &other)
+        {
+            Cycle copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    Cycle& operator=(Cycle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            m_inline = other.m_inline;
+            m_heap = std::move(other.m_heap);
+            m_size = other.m_size;
+            m_hash = other.m_hash;
+            other.m_size = 0;
+        }
+        return *this;
+    }
+
+    /// @return Frames of the cycle in ascending order.
+    [[nodiscard]] std::span<const Frame<Ts>> frames() const
+    {
+        return { m_heap ? m_heap.get() : m_inline.data(), m_size };
+    }
+
+    /// @return Smallest frame, which identifies the cycle because every other frame follows from it.
+    /// Only cycles with frames have one, a moved-from cycle has none.
+    [[nodiscard]] const Frame<Ts>& canonical() const
+    {
+        assert(m_size > 0);
+        return frames().front();
+    }
+
+    [[nodiscard]] bool contains(const Frame<Ts> &frame) const
+    {
+        return std::binary_search(frames().begin(), frames().end(), frame);
+    }
+
+    [[nodiscard]] size_t hash() const
+    {
+        return m_hash;
+    }
+
+    /// @brief Find the transform that maps the frames to their numerically smallest equivalent.
+    /// @param frames Frames of the cycle.
+    /// @return Transform applied to every frame of the cycle.
+    static Transform normalizing_transform(std::span<const Frame<Ts>> frames)
+    {
         Transform min_transform, temp_transform;
 
         Frame<Ts> min_frame(frames[0]), normalized(0);
@@ -52,42 +181,42 @@ public:
             }
         }
 
-        std::set<Frame<Ts>> frame_set;
-        for (const auto& frame : frames)
-        {
-            Frame<Ts> transformed = frame
-                .translated(min_transform.row_offset, min_transform.col_offset)
-                .transformed(min_transform.index);
-
-            frame_set.insert(transformed);
-        }
-        
-        return frame_set;
+        return min_transform;
     }
 
     struct Equal
     {
-        [[nodiscard]] constexpr bool operator()(const Cycle<Ts>& lhs, const Cycle<Ts>& rhs) const
+        [[nodiscard]] bool operator()(const Cycle<Ts>& lhs, const Cycle<Ts>& rhs) const
         {
-            return lhs.frames() == rhs.frames();
+            return lhs.hash() == rhs.hash()
+                && std::equal(lhs.frames().begin(), lhs.frames().end(), rhs.frames().begin(), rhs.frames().end());
+        }
+    };
+
+    /// @brief Strict ordering by frames, used to make results independent of discovery order.
+    struct Less
+    {
+        [[nodiscard]] bool operator()(const Cycle<Ts>& lhs, const Cycle<Ts>& rhs) const
+        {
+            return std::lexicographical_compare(
+                lhs.frames().begin(), lhs.frames().end(),
+                rhs.frames().begin(), rhs.frames().end());
         }
     };
 
     struct Hash
     {
-        [[nodiscard]] constexpr size_t operator()(const Cycle<Ts>& cycle) const
+        [[nodiscard]] size_t operator()(const Cycle<Ts>& cycle) const
         {
-            size_t seed = 0;
-            for (const auto& frame : cycle.frames())
-            {
-                const typename Frame<Ts>::Hash hasher;
-                seed ^= hasher(frame) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            }
-            return seed;
+            return cycle.hash();
         }
     };
 };
 
+/// @brief Set of normalized cycles.
+template<size_t Ts>
+using CycleSet = std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal>;
+
 template<size_t Ts>
 std::ostream& operator<<(std::ostream& os, const Cycle<Ts>& cycle)
 {
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <cycle.hpp>
+#include <frame.hpp>
+#include <resource_usage.hpp>
+
+/// @brief Compact store for very many normalized cycles. The frames of all cycles are packed
+/// into one arena, each cycle is an offset and length record and an open-addressing index keyed
+/// by the canonical frame maps to stable ids assigned in insertion order.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class CycleCatalogue
+{
+
+public:
+
+    struct Record
+    {
+        uint64_t offset;
+        uint32_t period;
+    };
+
+    struct MemoryUsage
+    {
+        size_t arena_bytes;
+        size_t record_bytes;
+        size_t index_bytes;
+        size_t total_bytes;
+        double bytes_per_cycle;
+        size_t peak_resident_bytes;
+    };
+
+private:
+
+    constexpr static uint32_t Empty = std::numeric_limits<uint32_t>::max();
+
+    std::vector<Frame<Ts>> m_arena;
+
+    std::vector<Record> m_records;
+
+    /// @brief Slots hold cycle ids, the key is read back from the arena.
+    std::vector<uint32_t> m_index;
+
+    size_t m_mask;
+
+    [[nodiscard]] size_t home(const Frame<Ts> &canonical) const
+    {
+        return typename Frame<Ts>::Hash()(canonical) & m_mask;
+    }
+
+    void rehash(size_t slot_count)
+    {
+        m_index.assign(slot_count, Empty);
+        m_mask = slot_count - 1;
+
+        for (uint32_t id = 0; id < m_records.size(); ++id)
+        {
+            size_t slot = home(m_arena[m_records[id].offset]);
+            while (Empty != m_index[slot])
+                slot = (slot + 1) & m_mask;
+            m_index[slot] = id;
+        }
+    }
+
+public:
+
+    /// @param expected_cycles Number of cycles to reserve index space for.
+    explicit CycleCatalogue(size_t expected_cycles = 1024)
+    {
+        m_records.reserve(expected_cycles);
+        rehash(std::bit_ceil(std::max<size_t>(2 * expected_cycles, 16)));
+    }
+
+    /// @brief Add a normalized cycle unless a cycle with the same canonical frame is already stored.
+    /// @return Id of the cycle and whether it was inserted.
+    std::pair<uint32_t, bool> insert(const Cycle<Ts> &cycle)
+    {
+        const Frame<Ts> &canonical = cycle.canonical();
+
+        size_t slot = home(canonical);
+        for (; Empty != m_index[slot]; slot = (slot + 1) & m_mask)
+        {
+            if (m_arena[m_records[m_index[slot]].offset] == canonical)
+                return { m_index[slot], false };
+        }
+
+        const auto id = static_cast<uint32_t>(m_records.size());
+        m_records.push_back({ m_arena.size(), static_cast<uint32_t>(cycle.frames().size()) });
+        m_arena.insert(m_arena.end(), cycle.frames().begin(), cycle.frames().end());
+        m_index[slot] = id;
+
+        // Keep the load factor at or below one half.
+        if (2 * m_records.size() > m_index.size())
+            rehash(2 * m_index.size());
+
+        return { id, true };
+    }
+
+    /// @brief Find a cycle by its canonical (smallest) frame.
+    [[nodiscard]] std::optional<uint32_t> find(const Frame<Ts> &canonical) const
+    {
+        for (size_t slot = home(canonical); Empty != m_index[slot]; slot = (slot + 1) & m_mask)
+        {
+            if (m_arena[m_records[m_index[slot]].offset] == canonical)
+                return m_index[slot];
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] std::optional<uint32_t> find(const Cycle<Ts> &cycle) const
+    {
+        return find(cycle.canonical());
+    }
+
+    /// @return Id of a cycle that must be in the catalogue, throws when it is not.
+    [[nodiscard]] uint32_t id(const Cycle<Ts> &cycle) const
+    {
+        const auto found = find(cycle);
+        if (!found)
+            throw std::runtime_error("Cycle is not in the catalogue");
+        return *found;
+    }
+
+    /// @return Frames of a cycle in ascending order.
+    [[nodiscard]] std::span<const Frame<Ts>> frames(uint32_t id) const
+    {
+        const Record &record = m_records[id];
+        return { m_arena.data() + record.offset, record.period };
+    }
+
+    [[nodiscard]] uint32_t period(uint32_t id) const
+    {
+        return m_records[id].period;
+    }
+
+    [[nodiscard]] Cycle<Ts> cycle(uint32_t id) const
+    {
+        return Cycle<Ts>::from_normalized(frames(id));
+    }
+
+    /// @brief Number of cycles.
+    [[nodiscard]] size_t size() const
+    {
+        return m_records.size();
+    }
+
+    /// @brief Total number of frames over all cycles.
+    [[nodiscard]] size_t frame_count() const
+    {
+        return m_arena.size();
+    }
+
+    [[nodiscard]] MemoryUsage memory_usage() const
+    {
+        MemoryUsage usage{};
+        usage.arena_bytes = m_arena.capacity() * sizeof(Frame<Ts>);
+        usage.record_bytes = m_records.capacity() * sizeof(Record);
+        usage.index_bytes = m_index.capacity() * sizeof(uint32_t);
+        usage.total_bytes = usage.arena_bytes + usage.record_bytes + usage.index_bytes;
+        usage.bytes_per_cycle = m_records.empty() ? 0.0 : static_cast<double>(usage.total_bytes) / m_records.size();
+        usage.peak_resident_bytes = peak_resident_bytes();
+        return usage;
+    }
+};
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+#include <async_writer.hpp>
+#include <cycle.hpp>
+#include <cycle_catalogue.hpp>
+#include <frame.hpp>
+
+/// @brief On-disk layout of a cycle database. Every section starts at a multiple of
+/// SectionAlignment from the beginning of the file so a mapped file can be used in place.
+///
+///     Header
+///     Record[cycle_count]        offset into the frames section and period of cycle id i
+///     Frame[frame_count]         frames of every cycle in ascending order, packed
+///     uint32_t[cycle_count]      cycle ids ordered by canonical frame
+///     uint32_t[cycle_count]      cycle ids ordered by period, then id
+namespace cycle_database
+{
+    constexpr char Magic[8] = { 'G', 'O', 'L', 'C', 'Y', 'C', 'D', 'B' };
+
+    constexpr uint32_t Version = 1;
+
+    constexpr uint64_t SectionAlignment = 64;
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t board_size;
+        uint32_t frame_bytes;
+        uint32_t reserved;
+        uint64_t cycle_count;
+        uint64_t frame_count;
+        uint64_t records_offset;
+        uint64_t frames_offset;
+        uint64_t canonical_index_offset;
+        uint64_t period_index_offset;
+        uint64_t file_size;
+    };
+
+    struct Record
+    {
+        uint64_t offset;
+        uint32_t period;
+        uint32_t reserved;
+    };
+
+    [[nodiscard]] constexpr uint64_t align(uint64_t offset)
+    {
+        return (offset + SectionAlignment - 1) / SectionAlignment * SectionAlignment;
+    }
+
+    /// @return Whether a section of count elements of element_size bytes starts aligned at offset and ends by file_size.
+    [[nodiscard]] constexpr bool section_fits(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t file_size)
+    {
+        return offset % SectionAlignment == 0
+            && offset >= sizeof(Header)
+            && offset <= file_size
+            && count <= (file_size - offset) / element_size;
+    }
+
+    /// @return Board size a database was written for, so tools can pick the matching CycleDatabase.
+    [[nodiscard]] inline uint32_t board_size(const std::filesystem::path &path)
+    {
+        std::ifstream is(path, std::ios::binary);
+        Header header{};
+        if (!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            throw std::runtime_error("Could not read cycle database: " + path.string());
+        if (0 != std::memcmp(header.magic, Magic, sizeof(Magic)))
+            throw std::runtime_error("Not a cycle database: " + path.string());
+        return header.board_size;
+    }
+}
+
+/// @brief Write a catalogue as a cycle database, ids are kept. The file is written next to its path
+/// and renamed into place once complete, so a killed job never leaves a database that looks finished.
+/// @param path Database file, replaced if it exists.
+template<size_t Ts>
+void write_cycle_database(const std::filesystem::path &path, const CycleCatalogue<Ts> &catalogue)
+{
+    using namespace cycle_database;
+
+    const auto cycle_count = static_cast<uint32_t>(catalogue.size());
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.board_size = Ts;
+    header.frame_bytes = sizeof(Frame<Ts>);
+    header.cycle_count = cycle_count;
+    header.frame_count = catalogue.frame_count();
+    header.records_offset = align(sizeof(Header));
+    header.frames_offset = align(header.records_offset + cycle_count * sizeof(Record));
+    header.canonical_index_offset = align(header.frames_offset + header.frame_count * sizeof(Frame<Ts>));
+    header.period_index_offset = align(header.canonical_index_offset + cycle_count * sizeof(uint32_t));
+    header.file_size = header.period_index_offset + cycle_count * sizeof(uint32_t);
+
+    std::vector<Record> records;
+    records.reserve(cycle_count);
+    uint64_t offset = 0;
+    for (uint32_t id = 0; id < cycle_count; ++id)
+    {
+        records.push_back({ offset, catalogue.period(id), 0 });
+        offset += catalogue.period(id);
+    }
+
+    std::vector<uint32_t> canonical_index(cycle_count);
+    for (uint32_t id = 0; id < cycle_count; ++id)
+        canonical_index[id] = id;
+    std::vector<uint32_t> period_index = canonical_index;
+
+    std::sort(canonical_index.begin(), canonical_index.end(), [&](uint32_t a, uint32_t b)
+    {
+        return catalogue.frames(a)[0] < catalogue.frames(b)[0];
+    });
+    std::stable_sort(period_index.begin(), period_index.end(), [&](uint32_t a, uint32_t b)
+    {
+        return catalogue.period(a) < catalogue.period(b);
+    });
+
+    const std::filesystem::path temporary = path.string() + ".tmp";
+    std::ofstream os(temporary, std::ios::binary | std::ios::trunc);
+    if (!os.is_open())
+        throw std::runtime_error("Could not open cycle database: " + temporary.string());
+
+    const auto pad_to = [&](uint64_t position)
+    {
+        static constexpr char zeros[SectionAlignment] = {};
+        os.write(zeros, static_cast<std::streamsize>(position - static_cast<uint64_t>(os.tellp())));
+    };
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    pad_to(header.records_offset);
+    os.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+
+    pad_to(header.frames_offset);
+    for (uint32_t id = 0; id < cycle_count; ++id)
+        os.write(reinterpret_cast<const char*>(catalogue.frames(id).data()), catalogue.frames(id).size_bytes());
+
+    pad_to(header.canonical_index_offset);
+    os.write(reinterpret_cast<const char*>(canonical_index.data()), canonical_index.size() * sizeof(uint32_t));
+
+    pad_to(header.period_index_offset);
+    os.write(reinterpret_cast<const char*>(period_index.data()), period_index.size() * sizeof(uint32_t));
+
+    os.close();
+    const int fd = os ? ::open(temporary.c_str(), O_RDONLY) : -1;
+    const bool synced = fd >= 0 && 0 == ::fsync(fd);
+    if (fd >= 0)
+        ::close(fd);
+    if (!synced)
+    {
+        std::filesystem::remove(temporary);
+        throw std::runtime_error("Could not write cycle database: " + temporary.string());
+    }
+
+    std::filesystem::rename(temporary, path);
+}
+
+/// @brief Read-only view of a cycle database file. The file is mapped into memory and queried
+/// in place, opening only checks that the header, the records and the indices stay inside the file.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class CycleDatabase
+{
+
+private:
+
+    const std::byte *m_data = nullptr;
+
+    size_t m_size = 0;
+
+    const cycle_database::Header *m_header = nullptr;
+
+    const cycle_database::Record *m_records = nullptr;
+
+    const Frame<Ts> *m_frames = nullptr;
+
+    const uint32_t *m_canonical_index = nullptr;
+
+    const uint32_t *m_period_index = nullptr;
+
+    void unmap()
+    {
+        if (nullptr != m_data)
+            ::munmap(const_cast<std::byte*>(m_data), m_size);
+        m_data = nullptr;
+    }
+
+public:
+
+    /// @param path Database written by write_cycle_database.
+    explicit CycleDatabase(const std::filesystem::path &path)
+    {
+        using namespace cycle_database;
+
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Could not open cycle database: " + path.string());
+
+        struct stat status{};
+        if (0 != ::fstat(fd, &status) || static_cast<size_t>(status.st_size) < sizeof(Header))
+        {
+            ::close(fd);
+            throw std::runtime_error("Cycle database is truncated: " + path.string());
+        }
+
+        m_size = static_cast<size_t>(status.st_size);
+        void *data = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (MAP_FAILED == data)
+            throw std::runtime_error("Could not map cycle database: " + path.string());
+        m_data = static_cast<const std::byte*>(data);
+
+        m_header = reinterpret_cast<const Header*>(m_data);
+        const char *error = nullptr;
+        if (0 != std::memcmp(m_header->magic, Magic, sizeof(Magic)))
+            error = "Not a cycle database: ";
+        else if (Version != m_header->version)
+            error = "Cycle database has an unsupported version: ";
+        else if (Ts != m_header->board_size || sizeof(Frame<Ts>) != m_header->frame_bytes)
+            error = "Cycle database was written for another board size: ";
+        else if (m_header->file_size > m_size)
+            error = "Cycle database is truncated: ";
+        else if (m_header->cycle_count > std::numeric_limits<uint32_t>::max()
+            || !section_fits(m_header->records_offset, m_header->cycle_count, sizeof(Record), m_header->file_size)
+            || !section_fits(m_header->frames_offset, m_header->frame_count, sizeof(Frame<Ts>), m_header->file_size)
+            || !section_fits(m_header->canonical_index_offset, m_header->cycle_count, sizeof(uint32_t), m_header->file_size)
+            || !section_fits(m_header->period_index_offset, m_header->cycle_count, sizeof(uint32_t), m_header->file_size))
+            error = "Cycle database has a section outside the file: ";
+
+        if (nullptr == error)
+        {
+            m_records = reinterpret_cast<const Record*>(m_data + m_header->records_offset);
+            m_frames = reinterpret_cast<const Frame<Ts>*>(m_data + m_header->frames_offset);
+            m_canonical_index = reinterpret_cast<const uint32_t*>(m_data + m_header->canonical_index_offset);
+            m_period_index = reinterpret_cast<const uint32_t*>(m_data + m_header->period_index_offset);
+
+            // Every cycle has frames inside the frames section and the indices only hold valid ids.
+            for (uint64_t id = 0; nullptr == error && id < m_header->cycle_count; ++id)
+            {
+                const Record &record = m_records[id];
+                if (0 == record.period
+                    || record.offset > m_header->frame_count
+                    || record.period > m_header->frame_count - record.offset)
+                    error = "Cycle database has a record outside the frames: ";
+                else if (m_canonical_index[id] >= m_header->cycle_count || m_period_index[id] >= m_header->cycle_count)
+                    error = "Cycle database has an index entry that is not a cycle: ";
+            }
+        }
+
+        if (nullptr != error)
+        {
+            unmap();
+            throw std::runtime_error(error + path.string());
+        }
+    }
+
+    CycleDatabase(const CycleDatabase&) = delete;
+
+    CycleDatabase& operator=(const CycleDatabase&) = delete;
+
+    CycleDatabase(CycleDatabase &&other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(other.m_size)
+    , m_header(other.m_header)
+    , m_records(other.m_records)
+    , m_frames(other.m_frames)
+    , m_canonical_index(other.m_canonical_index)
+    , m_period_index(other.m_period_index)
+    {
+
+    }
+
+    CycleDatabase& operator=(CycleDatabase &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = other.m_size;
+            m_header = other.m_header;
+            m_records = other.m_records;
+            m_frames = other.m_frames;
+            m_canonical_index = other.m_canonical_index;
+            m_period_index = other.m_period_index;
+        }
+        return *this;
+    }
+
+    ~CycleDatabase()
+    {
+        unmap();
+    }
+
+    /// @brief Number of cycles.
+    [[nodiscard]] size_t size() const
+    {
+        return m_header->cycle_count;
+    }
+
+    /// @brief Total number of frames over all cycles.
+    [[nodiscard]] size_t frame_count() const
+    {
+        return m_header->frame_count;
+    }
+
+    /// @return Frames of a cycle in ascending order.
+    [[nodiscard]] std::span<const Frame<Ts>> frames(uint32_t id) const
+    {
+        const auto &record = m_records[id];
+        return { m_frames + record.offset, record.period };
+    }
+
+    [[nodiscard]] uint32_t period(uint32_t id) const
+    {
+        return m_records[id].period;
+    }
+
+    [[nodiscard]] Cycle<Ts> cycle(uint32_t id) const
+    {
+        return Cycle<Ts>::from_normalized(frames(id));
+    }
+
+    /// @return Id of the cycle at a position of the order by canonical frame.
+    [[nodiscard]] uint32_t canonical_id(size_t position) const
+    {
+        return m_canonical_index[position];
+    }
+
+    /// @brief Find a cycle by its canonical (smallest) frame.
+    [[nodiscard]] std::optional<uint32_t> find(const Frame<Ts> &canonical) const
+    {
+        const std::span<const uint32_t> index(m_canonical_index, size());
+        const auto iter = std::lower_bound(index.begin(), index.end(), canonical, [&](uint32_t id, const Frame<Ts> &frame)
+        {
+            return frames(id)[0] < frame;
+        });
+
+        if (iter == index.end() || !(frames(*iter)[0] == canonical))
+            return std::nullopt;
+        return *iter;
+    }
+
+    [[nodiscard]] std::optional<uint32_t> find(const Cycle<Ts> &cycle) const
+    {
+        return find(cycle.canonical());
+    }
+
+    /// @return Ids of every cycle with the given period in ascending order.
+    [[nodiscard]] std::span<const uint32_t> ids_with_period(uint32_t period) const
+    {
+        const std::span<const uint32_t> index(m_period_index, size());
+        const auto first = std::partition_point(index.begin(), index.end(), [&](uint32_t id)
+        {
+            return this->period(id) < period;
+        });
+        const auto last = std::partition_point(first, index.end(), [&](uint32_t id)
+        {
+            return this->period(id) <= period;
+        });
+        return { first, last };
+    }
+
+    /// @return Every distinct period in ascending order.
+    [[nodiscard]] std::vector<uint32_t> periods() const
+    {
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i < size(); i += ids_with_period(period(m_period_index[i])).size())
+            result.push_back(period(m_period_index[i]));
+        return result;
+    }
+};
+
+/// @brief Append the frames of a cycle drawn side by side, one line per row.
+template<size_t Ts>
+void append_cycle_drawing(OutputBuffer &buffer, std::span<const Frame<Ts>> frames)
+{
+    for (size_t row = 0; row < Ts; ++row)
+    {
+        for (const auto &frame : frames)
+        {
+            for (size_t col = 0; col < Ts; ++col)
+                buffer.append(frame.get(row, col) ? "# " : ". ");
+            buffer.append("  ");
+        }
+        buffer.append('\n');
+    }
+}
+
+/// @brief Append one cycle in the text format of the configuration dumps read by the scripts:
+/// a header line, the packed frames and the frames drawn side by side.
+template<size_t Ts>
+void append_cycle_text(OutputBuffer &buffer, uint32_t id, std::span<const Frame<Ts>> frames)
+{
+    buffer.append("[T = ");
+    buffer.append(frames.size());
+    buffer.append(", id: ");
+    buffer.append(id);
+    buffer.append("]\n");
+
+    for (const auto &frame : frames)
+    {
+        buffer.append(frame.get());
+        buffer.append(' ');
+    }
+    buffer.append('\n');
+
+    append_cycle_drawing<Ts>(buffer, frames);
+    buffer.append('\n');
+}
+
+/// @brief Export a database in the text format of the configuration dumps read by the scripts.
+template<size_t Ts>
+void write_cycle_text(std::ostream &os, const CycleDatabase<Ts> &database)
+{
+    OutputBuffer buffer;
+    for (uint32_t id = 0; id < database.size(); ++id)
+    {
+        append_cycle_text<Ts>(buffer, id, database.frames(id));
+        os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+}
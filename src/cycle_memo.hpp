@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <checkpoint.hpp>
+#include <cycle.hpp>
+#include <frame.hpp>
+#include <instrumentation.hpp>
+
+/// @brief What the memo does when a frame finds no free slot in its probe window.
+enum class MemoEviction
+{
+    /// @brief Keep existing entries and drop the new frame.
+    Keep,
+    /// @brief Replace the entry at the home slot of the new frame.
+    Overwrite,
+    /// @brief Forget every frame (but not the cycles) and start over.
+    Flush
+};
+
+/// @brief Bounded lookup shared across find_cycle calls which maps visited frames
+/// to the index of the cycle they end up in.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class CycleMemo
+{
+
+public:
+
+    constexpr static size_t DefaultMemoryLimit = 64ull << 20;
+
+    constexpr static size_t ProbeLimit = 8;
+
+    struct Statistics
+    {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t insertions = 0;
+        size_t evictions = 0;
+        size_t flushes = 0;
+    };
+
+private:
+
+    constexpr static uint32_t Empty = std::numeric_limits<uint32_t>::max();
+
+    constexpr static size_t SlotBytes = sizeof(Frame<Ts>) + sizeof(uint32_t);
+
+    std::vector<Frame<Ts>> m_frames;
+
+    std::vector<uint32_t> m_cycle_indices;
+
+    size_t m_mask;
+
+    size_t m_size;
+
+    MemoEviction m_eviction;
+
+    std::vector<Cycle<Ts>> m_cycles;
+
+    std::unordered_map<Cycle<Ts>, size_t, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> m_cycle_lookup;
+
+    mutable Statistics m_statistics;
+
+    [[nodiscard]] size_t home(const Frame<Ts> &frame) const
+    {
+        return typename Frame<Ts>::Hash()(frame) & m_mask;
+    }
+
+public:
+
+    /// @param memory_limit Upper bound in bytes for the frame table, rounded down to a power of two slot count.
+    /// @param eviction Policy applied when a probe window is full.
+    explicit CycleMemo(size_t memory_limit = DefaultMemoryLimit, MemoEviction eviction = MemoEviction::Overwrite)
+    : m_size(0)
+    , m_eviction(eviction)
+    {
+        const size_t slots = std::bit_floor(std::max<size_t>(memory_limit / SlotBytes, ProbeLimit));
+        m_frames.resize(slots);
+        m_cycle_indices.assign(slots, Empty);
+        m_mask = slots - 1;
+    }
+
+    /// @brief Look up the cycle a frame ends up in.
+    /// @return Index of the cycle or nothing if the frame is not memoized.
+    [[nodiscard]] std::optional<size_t> find(const Frame<Ts> &frame) const
+    {
+        instrumentation::count(instrumentation::Counter::MemoLookups);
+        instrumentation::count(instrumentation::Counter::HashLookups);
+
+        size_t slot = home(frame);
+        for (size_t probe = 0; probe < ProbeLimit; ++probe, slot = (slot + 1) & m_mask)
+        {
+            instrumentation::count(instrumentation::Counter::HashProbes);
+            if (Empty == m_cycle_indices[slot])
+                break;
+
+            if (m_frames[slot] == frame)
+            {
+                instrumentation::count(instrumentation::Counter::MemoHits);
+                ++m_statistics.hits;
+                return m_cycle_indices[slot];
+            }
+        }
+
+        ++m_statistics.misses;
+        return std::nullopt;
+    }
+
+    /// @brief Remember the cycle a frame ends up in, evicting according to the policy when needed.
+    void insert(const Frame<Ts> &frame, size_t cycle_index)
+    {
+        instrumentation::count(instrumentation::Counter::HashLookups);
+
+        size_t slot = home(frame);
+        for (size_t probe = 0; probe < ProbeLimit; ++probe, slot = (slot + 1) & m_mask)
+        {
+            instrumentation::count(instrumentation::Counter::HashProbes);
+            if (Empty == m_cycle_indices[slot])
+            {
+                m_frames[slot] = frame;
+                m_cycle_indices[slot] = static_cast<uint32_t>(cycle_index);
+                ++m_size;
+                ++m_statistics.insertions;
+                return;
+            }
+
+            if (m_frames[slot] == frame)
+                return;
+        }
+
+        switch (m_eviction)
+        {
+            case MemoEviction::Keep:
+                break;
+
+            case MemoEviction::Overwrite:
+                slot = home(frame);
+                m_frames[slot] = frame;
+                m_cycle_indices[slot] = static_cast<uint32_t>(cycle_index);
+                ++m_statistics.evictions;
+                ++m_statistics.insertions;
+                break;
+
+            case MemoEviction::Flush:
+                clear_frames();
+                ++m_statistics.flushes;
+                insert(frame, cycle_index);
+                break;
+        }
+    }
+
+    /// @brief Register a cycle, returns the index of an equal cycle if it is already known.
+    size_t add_cycle(const Cycle<Ts> &cycle)
+    {
+        const auto [iter, inserted] = m_cycle_lookup.try_emplace(cycle, m_cycles.size());
+        if (inserted)
+            m_cycles.push_back(cycle);
+        return iter->second;
+    }
+
+    /// @brief Forget every memoized frame, known cycles keep their indices.
+    void clear_frames()
+    {
+        std::fill(m_cycle_indices.begin(), m_cycle_indices.end(), Empty);
+        m_size = 0;
+    }
+
+    /// @brief Serialize the known cycles and every memoized frame.
+    void save(std::ostream &os) const
+    {
+        checkpoint::write_cycles<Ts>(os, m_cycles);
+        checkpoint::write_value<uint64_t>(os, m_size);
+        for (size_t slot = 0; slot < m_frames.size(); ++slot)
+        {
+            if (Empty == m_cycle_indices[slot])
+                continue;
+
+            checkpoint::write_value(os, m_frames[slot]);
+            checkpoint::write_value(os, m_cycle_indices[slot]);
+        }
+    }
+
+    /// @brief Replace the contents with what save() wrote, frames are re-inserted into the current table.
+    void load(std::istream &is)
+    {
+        m_cycles.clear();
+        m_cycle_lookup.clear();
+        clear_frames();
+
+        for (const auto &cycle : checkpoint::read_cycles<Ts>(is))
+            add_cycle(cycle);
+
+        const auto entries = checkpoint::read_value<uint64_t>(is);
+        for (uint64_t entry = 0; entry < entries; ++entry)
+        {
+            const auto frame = checkpoint::read_value<Frame<Ts>>(is);
+            insert(frame, checkpoint::read_value<uint32_t>(is));
+        }
+    }
+
+    [[nodiscard]] const Cycle<Ts>& cycle(size_t index) const
+    {
+        return m_cycles[index];
+    }
+
+    [[nodiscard]] const std::vector<Cycle<Ts>>& cycles() const
+    {
+        return m_cycles;
+    }
+
+    /// @brief Number of memoized frames.
+    [[nodiscard]] size_t size() const
+    {
+        return m_size;
+    }
+
+    /// @brief Number of frame slots.
+    [[nodiscard]] size_t capacity() const
+    {
+        return m_frames.size();
+    }
+
+    [[nodiscard]] size_t memory_usage() const
+    {
+        return capacity() * SlotBytes;
+    }
+
+    [[nodiscard]] MemoEviction eviction() const
+    {
+        return m_eviction;
+    }
+
+    [[nodiscard]] const Statistics& statistics() const
+    {
+        return m_statistics;
+    }
+};
@@ -0,0 +1,350 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <checkpoint.hpp>
+#include <cycle.hpp>
+#include <cycle_memo.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <work_stealing.hpp>
+
+struct EnumerationOptions
+{
+    /// @brief Number of worker threads, zero picks the hardware concurrency.
+    size_t thread_count = 0;
+
+    /// @brief Number of consecutive start states handed out as one task.
+    uint64_t chunk_size = 1 << 14;
+
+    /// @brief Byte budget of the memo owned by each worker.
+    size_t memo_memory_limit = 64ull << 20;
+
+    /// @brief Only simulate start states that are the normalized representative of their
+    /// translation x D4 orbit, the other members of the orbit reach an equivalent cycle. This filters
+    /// the range instead of generating representatives: Frame::next_canonical_candidate() jumps over
+    /// the states whose rows rule them out and canonical_orbit_size() tests the others, so the scan
+    /// still costs O(2^(N^2)), only with a smaller constant. 2.7M of the 2^25 5x5 states are tested.
+    bool symmetry_reduced = false;
+
+    /// @brief Count how many start states end up in each cycle. With symmetry reduction every
+    /// representative counts for its whole orbit, including the members outside the range, so the
+    /// weights are only exact when every orbit has its representative inside the range, as for the
+    /// whole board.
+    bool record_basin_weights = false;
+
+    /// @brief Split the chunks over shard_count independent runs, this run only takes the chunks whose
+    /// index modulo shard_count is shard_index. Interleaving keeps the shards balanced, orbit
+    /// representatives crowd at the small states.
+    uint64_t shard_index = 0;
+
+    uint64_t shard_count = 1;
+
+    /// @brief Print a line every time another 5% of the chunks is done.
+    bool report_progress = false;
+
+    /// @brief File the enumeration state is written to after every round of chunks, empty disables checkpoints.
+    std::filesystem::path checkpoint_path;
+
+    /// @brief Number of chunks in one round between two checkpoints.
+    size_t checkpoint_chunks = 1024;
+
+    /// @brief Continue from checkpoint_path when it exists instead of starting over.
+    bool resume = false;
+
+    /// @brief Also save the memo of every worker in the checkpoint, so a resumed run starts with warm
+    /// memos. Every checkpoint then grows by up to memo_memory_limit per worker.
+    bool checkpoint_memos = false;
+
+    /// @brief Stop after this many rounds of chunks and return what was found so far, zero runs to the
+    /// end. A run resumed from the checkpoint continues with the next round, which splits a long
+    /// enumeration into jobs of bounded length.
+    size_t round_limit = 0;
+};
+
+/// @brief Finds the cycles reached from every state of a range of start states in parallel.
+/// Each worker has its own game, scratch buffers and memo. The per-worker cycles are merged
+/// and inserted in sorted order at the end, so the result does not depend on the thread count.
+/// With a checkpoint path the chunks are processed in rounds and the cursor, the cycles found so
+/// far and the basin weights are saved after each round, so an interrupted run resumed from its
+/// checkpoint returns exactly what an uninterrupted run would.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class ParallelEnumerator
+{
+
+private:
+
+    struct Worker
+    {
+        GameOfLife<Ts> game;
+        std::vector<Frame<Ts>> trajectory;
+        CycleMemo<Ts> memo;
+        std::vector<uint64_t> basin_weights;
+
+        /// @brief Number of memo cycles already merged into the accumulated cycles.
+        size_t merged = 0;
+
+        explicit Worker(size_t memo_memory_limit)
+        : memo(memo_memory_limit)
+        {
+
+        }
+    };
+
+    EnumerationOptions m_options;
+
+    WorkStealingScheduler m_scheduler;
+
+    constexpr static uint32_t CheckpointMagic = 0x454C4F47; // "GOLE"
+
+    std::unordered_map<Cycle<Ts>, uint64_t, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> m_basin_weights;
+
+    /// @brief Cycles found by the finished rounds, sorted and unique.
+    std::vector<Cycle<Ts>> m_cycles;
+
+    /// @brief Fold the cycles and basin weights of every worker into the accumulated state.
+    void merge(std::vector<std::unique_ptr<Worker>> &workers)
+    {
+        // Memos only ever append cycles, so a round costs the cycles it found and not all found so far.
+        std::vector<Cycle<Ts>> found;
+        for (const auto &worker : workers)
+        {
+            const auto &cycles = worker->memo.cycles();
+            found.insert(found.end(), cycles.begin() + static_cast<std::ptrdiff_t>(worker->merged), cycles.end());
+            worker->merged = cycles.size();
+        }
+
+        if (!found.empty())
+        {
+            std::sort(found.begin(), found.end(), typename Cycle<Ts>::Less());
+            const auto middle = m_cycles.insert(m_cycles.end(), std::make_move_iterator(found.begin()), std::make_move_iterator(found.end()));
+            std::inplace_merge(m_cycles.begin(), middle, m_cycles.end(), typename Cycle<Ts>::Less());
+            m_cycles.erase(
+                std::unique(m_cycles.begin(), m_cycles.end(), typename Cycle<Ts>::Equal()),
+                m_cycles.end());
+        }
+
+        for (auto &worker : workers)
+        {
+            for (size_t cycle_index = 0; cycle_index < worker->basin_weights.size(); ++cycle_index)
+            {
+                if (0 != worker->basin_weights[cycle_index])
+                    m_basin_weights[worker->memo.cycle(cycle_index)] += worker->basin_weights[cycle_index];
+            }
+            worker->basin_weights.clear();
+        }
+    }
+
+    void save_checkpoint(
+        absl::uint128 begin,
+        absl::uint128 end,
+        size_t next_chunk,
+        const std::vector<std::unique_ptr<Worker>> &workers) const
+    {
+        checkpoint::write_atomically(m_options.checkpoint_path, [&](std::ostream &os)
+        {
+            checkpoint::write_header(os, CheckpointMagic, Ts);
+            checkpoint::write_value(os, begin);
+            checkpoint::write_value(os, end);
+            checkpoint::write_value(os, m_options.chunk_size);
+            checkpoint::write_value<uint8_t>(os, m_options.symmetry_reduced);
+            checkpoint::write_value(os, m_options.shard_index);
+            checkpoint::write_value(os, m_options.shard_count);
+            checkpoint::write_value<uint64_t>(os, next_chunk);
+
+            checkpoint::write_cycles<Ts>(os, m_cycles);
+            for (const auto &cycle : m_cycles)
+            {
+                const auto iter = m_basin_weights.find(cycle);
+                checkpoint::write_value<uint64_t>(os, iter == m_basin_weights.end() ? 0 : iter->second);
+            }
+
+            checkpoint::write_value<uint64_t>(os, m_options.checkpoint_memos ? workers.size() : 0);
+            if (m_options.checkpoint_memos)
+            {
+                for (const auto &worker : workers)
+                    worker->memo.save(os);
+            }
+        });
+    }
+
+    /// @return Index of the first chunk that still has to be processed.
+    [[nodiscard]] size_t load_checkpoint(
+        absl::uint128 begin,
+        absl::uint128 end,
+        std::vector<std::unique_ptr<Worker>> &workers)
+    {
+        std::ifstream is = checkpoint::open(m_options.checkpoint_path);
+        checkpoint::read_header(is, CheckpointMagic, Ts);
+
+        if (checkpoint::read_value<absl::uint128>(is) != begin
+            || checkpoint::read_value<absl::uint128>(is) != end
+            || checkpoint::read_value<uint64_t>(is) != m_options.chunk_size
+            || checkpoint::read_value<uint8_t>(is) != static_cast<uint8_t>(m_options.symmetry_reduced)
+            || checkpoint::read_value<uint64_t>(is) != m_options.shard_index
+            || checkpoint::read_value<uint64_t>(is) != m_options.shard_count)
+            throw std::runtime_error("Checkpoint belongs to another enumeration");
+
+        const auto next_chunk = checkpoint::read_value<uint64_t>(is);
+
+        m_cycles = checkpoint::read_cycles<Ts>(is);
+        for (const auto &cycle : m_cycles)
+        {
+            const auto weight = checkpoint::read_value<uint64_t>(is);
+            if (0 != weight)
+                m_basin_weights[cycle] = weight;
+        }
+
+        // Memos only speed things up, they are missing unless checkpoint_memos was set and with a
+        // different thread count the extra ones are dropped.
+        const auto memo_count = checkpoint::read_value<uint64_t>(is);
+        for (uint64_t i = 0; i < memo_count; ++i)
+        {
+            if (i < workers.size())
+            {
+                // The saved memos only hold cycles that were merged before the checkpoint.
+                workers[i]->memo.load(is);
+                workers[i]->merged = workers[i]->memo.cycles().size();
+            }
+            else
+            {
+                CycleMemo<Ts> discarded(0);
+                discarded.load(is);
+            }
+        }
+
+        return static_cast<size_t>(next_chunk);
+    }
+
+public:
+
+    explicit ParallelEnumerator(const EnumerationOptions &options = {})
+    : m_options(options)
+    , m_scheduler(options.thread_count)
+    {
+
+    }
+
+    [[nodiscard]] size_t thread_count() const
+    {
+        return m_scheduler.thread_count();
+    }
+
+    [[nodiscard]] size_t steals() const
+    {
+        return m_scheduler.steals();
+    }
+
+    /// @brief Number of start states that ended up in each cycle during the last enumeration,
+    /// only filled when record_basin_weights is set.
+    [[nodiscard]] const std::unordered_map<Cycle<Ts>, uint64_t, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal>&
+    basin_weights() const
+    {
+        return m_basin_weights;
+    }
+
+    /// @brief Find every cycle reached from start states in [begin, end), or from the chunks of
+    /// the shard when the options split the range.
+    [[nodiscard]] CycleSet<Ts> enumerate(
+        absl::uint128 begin,
+        absl::uint128 end)
+    {
+        const absl::uint128 state_count = end > begin ? end - begin : 0;
+        const auto total_chunks = static_cast<size_t>((state_count + m_options.chunk_size - 1) / m_options.chunk_size);
+
+        // Chunk i of this run is chunk shard_index + i * shard_count of the range.
+        const uint64_t shard_count = std::max<uint64_t>(m_options.shard_count, 1);
+        const size_t chunk_count = m_options.shard_index < total_chunks
+            ? static_cast<size_t>((total_chunks - m_options.shard_index + shard_count - 1) / shard_count)
+            : 0;
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (size_t i = 0; i < m_scheduler.thread_count(); ++i)
+            workers.push_back(std::make_unique<Worker>(m_options.memo_memory_limit));
+
+        m_basin_weights.clear();
+        m_cycles.clear();
+
+        size_t next_chunk = 0;
+        if (m_options.resume && std::filesystem::exists(m_options.checkpoint_path))
+            next_chunk = load_checkpoint(begin, end, workers);
+
+        const size_t round_size = m_options.checkpoint_path.empty()
+            ? std::max<size_t>(chunk_count, 1)
+            : std::max<size_t>(m_options.checkpoint_chunks, 1);
+
+        std::atomic<size_t> chunks_done = next_chunk;
+        std::mutex progress_mutex;
+        const size_t chunks_per_step = std::max<size_t>(chunk_count / 20, 1);
+
+        size_t rounds = 0;
+        while (next_chunk < chunk_count && (0 == m_options.round_limit || rounds++ < m_options.round_limit))
+        {
+            const size_t round_begin = next_chunk;
+            const size_t round_end = std::min(round_begin + round_size, chunk_count);
+
+            m_scheduler.run(round_end - round_begin, [&](size_t worker_index, size_t task_index)
+            {
+                Worker &worker = *workers[worker_index];
+                const size_t chunk_index = m_options.shard_index + (round_begin + task_index) * shard_count;
+
+                const absl::uint128 chunk_begin = begin + absl::uint128(chunk_index) * m_options.chunk_size;
+                const typename Frame<Ts>::State chunk_end = std::min(chunk_begin + m_options.chunk_size, end);
+
+                for (typename Frame<Ts>::State state = chunk_begin; state < chunk_end; ++state)
+                {
+                    uint64_t weight = 1;
+                    if (m_options.symmetry_reduced)
+                    {
+                        if (!Frame<Ts>::next_canonical_candidate(state) || state >= chunk_end)
+                            break;
+
+                        weight = Frame<Ts>(state).canonical_orbit_size();
+                        if (0 == weight)
+                            continue;
+                    }
+
+                    const Frame<Ts> frame(state);
+
+                    worker.game.set(frame);
+                    const size_t cycle_index = worker.game.find_cycle(worker.memo, worker.trajectory);
+
+                    if (m_options.record_basin_weights)
+                    {
+                        if (worker.basin_weights.size() <= cycle_index)
+                            worker.basin_weights.resize(cycle_index + 1, 0);
+                        worker.basin_weights[cycle_index] += weight;
+                    }
+                }
+
+                const size_t done = ++chunks_done;
+                if (m_options.report_progress && done % chunks_per_step == 0)
+                {
+                    std::lock_guard lock(progress_mutex);
+                    std::cout << "Searched " << 100 * static_cast<double>(done) / static_cast<double>(chunk_count)
+                              << "% of all states\n";
+                }
+            });
+
+            next_chunk = round_end;
+            merge(workers);
+
+            if (!m_options.checkpoint_path.empty())
+                save_checkpoint(begin, end, next_chunk, workers);
+        }
+
+        CycleSet<Ts> cycles;
+        for (const auto &cycle : m_cycles)
+            cycles.insert(cycle);
+
+        return cycles;
+    }
+};
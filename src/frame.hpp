@@ -1,30 +1,55 @@
 #pragma once
+#include <array>
+#include <bit>
 #include <ostream>
+#include <type_traits>
+#include <vector>
 #include <absl/numeric/int128.h>
+#include <instrumentation.hpp>
 #include <transform.hpp>
+#include <uint256.hpp>
 
 /// @brief
-/// @tparam N width and height of the frame
+/// @tparam N width and height of the frame, boards up to 11x11 are packed into an absl::uint128
+/// and larger ones up to 16x16 into a uint256.
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 class Frame {
 
+public:
+
+    /// @brief Packed board, bit col + row * N holds the cell at (row, col).
+    using State = std::conditional_t<(N <= 11), absl::uint128, uint256>;
+
 private:
 
-    absl::uint128 m_state;
+    State m_state;
 
 public:
 
     constexpr static size_t CellCount = N * N;
 
-    constexpr static absl::uint128 States = 1ull << CellCount;
+    /// @brief Number of distinct boards, 2^121 for 11x11 still fits. Wraps to zero for 16x16.
+    constexpr static State States = State(1) << CellCount;
+
+    /// @brief Mask with all CellCount bits of the board set.
+    constexpr static State BoardMask = (State(1) << CellCount) - 1;
+
+    /// @brief Rows are transposed in chunks of this many bits, keeps the lookup small for wide boards.
+    constexpr static size_t RowChunkBits = N <= 11 ? N : 8;
+
+    /// @brief Mask with all N bits of a single row set.
+    constexpr static uint16_t RowMask = (1u << N) - 1;
+
+    /// @brief Frame split into rows, element r holds the N bits of row r.
+    using Rows = std::array<uint16_t, N>;
 
 public:
 
     constexpr Frame();
-    constexpr Frame(absl::uint128 state);
+    constexpr Frame(State state);
 
-    [[nodiscard]] constexpr absl::uint128 get() const;
+    [[nodiscard]] constexpr State get() const;
     [[nodiscard]] constexpr bool get(size_t index) const;
     [[nodiscard]] constexpr bool get(size_t row, size_t col) const;
 
@@ -52,6 +77,36 @@ public:
     /// @return Equivalent frame with minimal numerical value.
     [[nodiscard]] constexpr Frame<N> normalized(Transform &min_transform) const;
 
+    /// @brief Retrieve normalized frame by trying every translation and transform one after another.
+    /// Baseline for normalized() that still shares translated() and transformed() with the row engine,
+    /// the tests check both against a cell by cell reference.
+    /// @param min_transform Transform that normalizes this frame.
+    /// @return Equivalent frame with minimal numerical value.
+    [[nodiscard]] constexpr Frame<N> normalized_reference(Transform &min_transform) const;
+
+    /// @brief Check whether this frame is the normalized representative of its orbit and count the orbit.
+    /// Returns as soon as a smaller translation or transform is found.
+    /// @return Number of distinct frames in the translation x D4 orbit, zero if a smaller equivalent frame exists.
+    [[nodiscard]] constexpr size_t canonical_orbit_size() const;
+
+    /// @return Whether no translation or transform of this frame is smaller.
+    [[nodiscard]] constexpr bool is_canonical() const;
+
+    /// @brief Advance to the next state whose rows pass the lower bound of normalized(): a canonical
+    /// frame has a top row that is the smallest rotation and reflection of itself and of every other
+    /// row. States in between are never canonical, the ones reached still need canonical_orbit_size().
+    /// @param state Packed board state, replaced by the smallest passing state that is not smaller.
+    /// @return False when no passing state is left.
+    [[nodiscard]] constexpr static bool next_canonical_candidate(State &state);
+
+    /// @brief Find the translations and transforms that leave this frame unchanged.
+    /// @return Every transform t with translated(t.row_offset, t.col_offset).transformed(t.index) equal to this frame, the identity first.
+    [[nodiscard]] std::vector<Transform> stabilizer() const;
+
+    /// @brief Follow a single cell through a translation and transform.
+    /// @return Index of the cell that cell ends up in when the frame is translated and then transformed.
+    [[nodiscard]] constexpr static size_t transformed_cell(size_t cell, const Transform &transform);
+
     [[nodiscard]] constexpr Frame<N> translated(size_t row_offset, size_t col_offset) const;
 
     /// @brief Flip frame.
@@ -97,12 +152,54 @@ public:
     /// @return Transformed frame.
     [[nodiscard]] constexpr Frame<N> transformed(size_t transform_index) const;
 
-    [[nodiscard]] constexpr static absl::uint128 get_neighbour_mask(size_t cell_row, size_t cell_col);
-    [[nodiscard]] constexpr static std::array<absl::uint128, CellCount> create_neighbour_mask_lut();
-    [[nodiscard]] constexpr static std::array<std::array<size_t, N>, N> create_index_lut();
+    [[nodiscard]] constexpr Rows rows() const;
+    [[nodiscard]] constexpr static Frame<N> from_rows(const Rows &rows);
+
+    /// @brief Apply a D4 transform to a frame split into rows.
+    /// @param rows Rows of the frame.
+    /// @param transform_index Index of the D4 group Cayley table node, see transformed().
+    /// @return Rows of the transformed frame.
+    [[nodiscard]] constexpr static Rows transform_rows(const Rows &rows, size_t transform_index);
+
+    /// @brief Cyclically shift the bits of a row, bit c of the result is bit (c + offset) % N of the row.
+    [[nodiscard]] constexpr static uint16_t rotate_row(uint16_t row, size_t offset);
 
-    constexpr static std::array<absl::uint128, CellCount> neighbour_mask_lookup = create_neighbour_mask_lut();
+    [[nodiscard]] constexpr static size_t popcount(State state);
+
+    [[nodiscard]] constexpr static State get_neighbour_mask(size_t cell_row, size_t cell_col);
+    [[nodiscard]] constexpr static std::array<State, CellCount> create_neighbour_mask_lut();
+    [[nodiscard]] constexpr static std::array<std::array<size_t, N>, N> create_index_lut();
+    [[nodiscard]] constexpr static std::array<State, N + 1> create_column_mask_lut();
+    [[nodiscard]] constexpr static std::array<uint16_t, 1 << N> create_row_reverse_lut();
+    [[nodiscard]] constexpr static std::array<uint16_t, 1 << N> create_row_min_rotation_lut();
+    [[nodiscard]] constexpr static std::array<State, 1 << RowChunkBits> create_row_transpose_lut();
+
+    /// @brief Cyclically shift whole rows of a packed board.
+    /// @param state Packed board state.
+    /// @param offset Row offset, row r of the result is row (r + offset) % N of the state.
+    /// @return Shifted board state.
+    [[nodiscard]] constexpr static State translate_rows(State state, size_t offset);
+
+    /// @brief Cyclically shift the columns inside every row of a packed board.
+    /// @param state Packed board state.
+    /// @param offset Column offset, column c of the result is column (c + offset) % N of the state.
+    /// @return Shifted board state.
+    [[nodiscard]] constexpr static State translate_cols(State state, size_t offset);
+
+    constexpr static std::array<State, CellCount> neighbour_mask_lookup = create_neighbour_mask_lut();
     constexpr static std::array<std::array<size_t, N>, N> index_lookup = create_index_lut();
+
+    /// @brief Entry k masks columns [0, k) of every row.
+    constexpr static std::array<State, N + 1> column_mask_lookup = create_column_mask_lut();
+
+    /// @brief Entry v holds the N bits of row v in reverse order.
+    constexpr static std::array<uint16_t, 1 << N> row_reverse_lookup = create_row_reverse_lut();
+
+    /// @brief Entry v holds the smallest cyclic rotation of row v.
+    constexpr static std::array<uint16_t, 1 << N> row_min_rotation_lookup = create_row_min_rotation_lut();
+
+    /// @brief Entry v holds the RowChunkBits bits of v laid out as column 0 of an otherwise empty board.
+    constexpr static std::array<State, 1 << RowChunkBits> row_transpose_lookup = create_row_transpose_lut();
 };
 
 template<size_t Ts>
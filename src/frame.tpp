@@ -1,117 +1,312 @@
+#include <algorithm>
 #include "absl/hash/hash.h"
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr Frame<N>::Frame()
 : m_state(0)
 { }
 
 template <size_t N>
-requires(N <= 11)
-constexpr Frame<N>::Frame(absl::uint128 state)
+requires(N <= 16)
+constexpr Frame<N>::Frame(State state)
 : m_state(state)
 { }
 
 template <size_t N>
-requires(N <= 11)
-constexpr absl::uint128 Frame<N>::get() const
+requires(N <= 16)
+constexpr typename Frame<N>::State Frame<N>::get() const
 {
     return m_state;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr bool Frame<N>::get(size_t index) const
 {
-    const absl::uint128 mask = 1;
+    const State mask = 1;
     auto masked = m_state & (mask << index);
     return masked > 0;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 [[nodiscard]] constexpr bool Frame<N>::get(size_t row, size_t col) const
 {
-    const absl::uint128 mask = 1;
+    const State mask = 1;
     const auto masked = m_state & (mask << index_lookup[row][col]);
     return masked > 0;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr void Frame<N>::set(size_t index) {
-    const absl::uint128 one = 1;
+    const State one = 1;
     m_state |= one << index;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr void Frame<N>::set(size_t index, bool value) {
-    const absl::uint128 bit = value;
+    const State bit = value;
     m_state |= bit << index;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr void Frame<N>::set(size_t row, size_t col, bool value) {
-    const absl::uint128 bit = value;
+    const State bit = value;
     m_state |= bit << index_lookup[row][col];
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr void Frame<N>::set(size_t row, size_t col) {
-    const absl::uint128 one = 1;
+    const State one = 1;
     m_state |= one << index_lookup[row][col];
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr size_t Frame<N>::to_index(size_t row, size_t col)
 {
     return col + row * N;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
 constexpr void Frame<N>::toggle(size_t index) {
-    const absl::uint128 one = 1;
+    const State one = 1;
     m_state ^= one << index;
 }
 
 template <size_t N>
-requires(N <= 11)
+requires(N <= 16)
+constexpr size_t Frame<N>::popcount(State state) {
+    if constexpr (std::is_same_v<State, absl::uint128>)
+        return std::popcount(absl::Uint128High64(state)) + std::popcount(absl::Uint128Low64(state));
+    else
+        return state.popcount();
+}
+
+template <size_t N>
+requires(N <= 16)
 [[nodiscard]] constexpr size_t Frame<N>::neighbour_cnt(size_t index) const {
-    const absl::uint128 near = m_state & neighbour_mask_lookup[index];
-    const auto high = absl::Uint128High64(near);
-    const auto low = absl::Uint128Low64(near);
-    return std::popcount(high) + std::popcount(low);
+    return popcount(m_state & neighbour_mask_lookup[index]);
 }
 
 template<size_t Ts>
-requires(Ts <= 11)bool Frame<Ts>::operator==(const Frame<Ts> &other) const {
+requires(Ts <= 16)bool Frame<Ts>::operator==(const Frame<Ts> &other) const {
     return get() == other.get();
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr auto Frame<Ts>::operator<(const Frame<Ts> &other) const {
+requires(Ts <= 16)constexpr auto Frame<Ts>::operator<(const Frame<Ts> &other) const {
     return get() < other.get();
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr auto Frame<Ts>::operator>(const Frame<Ts> &other) const {
+requires(Ts <= 16)constexpr auto Frame<Ts>::operator>(const Frame<Ts> &other) const {
     return get() > other.get();
 }
 
 template<size_t Ts>
-requires(Ts <= 11)size_t Frame<Ts>::Hash::operator()(const Frame<Ts> &frame) const {
+requires(Ts <= 16)size_t Frame<Ts>::Hash::operator()(const Frame<Ts> &frame) const {
 
-    const absl::Hash<absl::uint128> hasher;
+    const absl::Hash<State> hasher;
     return hasher(frame.get());
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr Frame<Ts> Frame<Ts>::normalized(Transform &min_transform) const {
+requires(Ts <= 16)constexpr Frame<Ts> Frame<Ts>::normalized(Transform &min_transform) const {
+    instrumentation::count(instrumentation::Counter::Normalizations);
+
+    // Translating and then transforming equals transforming and then translating by the
+    // transformed offsets, so each transform is applied once and its rows are slid around.
+    const Rows source = rows();
+    Rows min_rows = source;
+    min_transform = Transform();
+
+    for (size_t index = 0; index < 8; ++index) {
+        const Rows image = transform_rows(source, index);
+
+        for (size_t row_offset = 0; row_offset < Ts; ++row_offset) {
+
+            // Lower bound, the top row can at best become its smallest rotation.
+            if (row_min_rotation_lookup[image[(Ts - 1 + row_offset) % Ts]] > min_rows[Ts - 1])
+                continue;
+
+            for (size_t col_offset = 0; col_offset < Ts; ++col_offset) {
+
+                // Compare from the most significant row and reject as soon as the candidate is larger.
+                int order = 0;
+                for (size_t row = Ts; 0 == order && row > 0; --row) {
+                    const uint16_t value = rotate_row(image[(row - 1 + row_offset) % Ts], col_offset);
+                    order = value < min_rows[row - 1] ? -1 : (value > min_rows[row - 1] ? 1 : 0);
+                }
+
+                if (order > 0)
+                    continue;
+
+                // Offsets of the equivalent translate-then-transform, ties resolve like the reference loop.
+                const size_t a = row_offset, b = col_offset, na = (Ts - a) % Ts, nb = (Ts - b) % Ts;
+                Transform transform;
+                switch (index) {
+                    case 0: transform = {a, b, index}; break;
+                    case 1: transform = {a, nb, index}; break;
+                    case 2: transform = {nb, na, index}; break;
+                    case 3: transform = {nb, a, index}; break;
+                    case 4: transform = {na, nb, index}; break;
+                    case 5: transform = {na, b, index}; break;
+                    case 6: transform = {b, a, index}; break;
+                    default: transform = {b, na, index}; break;
+                }
+
+                if (0 == order) {
+                    const bool earlier =
+                        transform.row_offset != min_transform.row_offset ? transform.row_offset < min_transform.row_offset :
+                        transform.col_offset != min_transform.col_offset ? transform.col_offset < min_transform.col_offset :
+                        transform.index < min_transform.index;
+                    if (!earlier)
+                        continue;
+                }
+
+                for (size_t row = 0; row < Ts; ++row)
+                    min_rows[row] = rotate_row(image[(row + row_offset) % Ts], col_offset);
+                min_transform = transform;
+            }
+        }
+    }
+
+    return from_rows(min_rows);
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr size_t Frame<Ts>::canonical_orbit_size() const {
+    const Rows source = rows();
+    size_t stabilizer_size = 0;
+
+    for (size_t index = 0; index < 8; ++index) {
+        const Rows image = transform_rows(source, index);
+
+        for (size_t row_offset = 0; row_offset < Ts; ++row_offset) {
+
+            if (row_min_rotation_lookup[image[(Ts - 1 + row_offset) % Ts]] > source[Ts - 1])
+                continue;
+
+            for (size_t col_offset = 0; col_offset < Ts; ++col_offset) {
+
+                int order = 0;
+                for (size_t row = Ts; 0 == order && row > 0; --row) {
+                    const uint16_t value = rotate_row(image[(row - 1 + row_offset) % Ts], col_offset);
+                    order = value < source[row - 1] ? -1 : (value > source[row - 1] ? 1 : 0);
+                }
+
+                if (order < 0)
+                    return 0;
+
+                if (0 == order)
+                    ++stabilizer_size;
+            }
+        }
+    }
+
+    return 8 * CellCount / stabilizer_size;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr bool Frame<Ts>::is_canonical() const {
+    return canonical_orbit_size() > 0;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr bool Frame<Ts>::next_canonical_candidate(State &state) {
+    // Every row of every transformed image is a row or column of the frame, possibly reversed.
+    // The top row of the frame can not exceed the smallest rotation of any of them.
+    const auto class_min = [](uint32_t row) {
+        return std::min(row_min_rotation_lookup[row], row_min_rotation_lookup[row_reverse_lookup[row]]);
+    };
+    // Smallest row from value on that the top row does not exceed, RowMask + 1 if there is none.
+    const auto next_row = [&](uint32_t value, uint32_t top) {
+        while (value <= RowMask && class_min(value) < top)
+            ++value;
+        return value;
+    };
+    const auto next_top = [&](uint32_t value) {
+        while (value <= RowMask && class_min(value) != value)
+            ++value;
+        return value;
+    };
+
+    Rows rows = Frame<Ts>(state).rows();
+
+    // Rows from the most significant one down, the first one that fails is raised and the ones
+    // below it start over from the smallest row that passes.
+    uint32_t top = next_top(rows[Ts - 1]);
+    if (top > RowMask)
+        return false;
+
+    size_t raised = Ts - 1;
+    if (top == rows[Ts - 1]) {
+        while (raised > 0 && class_min(rows[raised - 1]) >= top)
+            --raised;
+        if (0 == raised)
+            return true;
+
+        // Carry into the more significant rows while a row runs out of passing values.
+        uint32_t value = next_row(rows[--raised], top);
+        while (value > RowMask && raised < Ts - 2)
+            value = next_row(rows[++raised] + 1u, top);
+
+        if (value > RowMask) {
+            raised = Ts - 1;
+            top = next_top(top + 1);
+            if (top > RowMask)
+                return false;
+            value = top;
+        }
+        rows[raised] = static_cast<uint16_t>(value);
+    }
+    else {
+        rows[Ts - 1] = static_cast<uint16_t>(top);
+    }
+
+    const auto lowest = static_cast<uint16_t>(next_row(0, top));
+    for (size_t row = 0; row < raised; ++row)
+        rows[row] = lowest;
+
+    state = from_rows(rows).get();
+    return true;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)std::vector<Transform> Frame<Ts>::stabilizer() const {
+    std::vector<Transform> transforms;
+    for (size_t index = 0; index < 8; ++index) {
+        for (size_t row_offset = 0; row_offset < Ts; ++row_offset) {
+            for (size_t col_offset = 0; col_offset < Ts; ++col_offset) {
+                if (translated(row_offset, col_offset).transformed(index) == *this)
+                    transforms.emplace_back(row_offset, col_offset, index);
+            }
+        }
+    }
+    return transforms;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr size_t Frame<Ts>::transformed_cell(size_t cell, const Transform &transform) {
+    Frame<Ts> single;
+    single.set(cell);
+    const Rows image = single.translated(transform.row_offset, transform.col_offset).transformed(transform.index).rows();
+    for (size_t row = 0; row < Ts; ++row) {
+        if (image[row] != 0)
+            return to_index(row, std::countr_zero(image[row]));
+    }
+    return cell;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr Frame<Ts> Frame<Ts>::normalized_reference(Transform &min_transform) const {
     min_transform = Transform();
     Frame<Ts> min_state(m_state);
     for (size_t row_offset = 0; row_offset < Ts; ++row_offset) {
@@ -179,66 +374,30 @@ requires(Ts <= 11)constexpr Frame<Ts> Frame<Ts>::normalized(Transform &min_trans
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr Frame<Ts> Frame<Ts>::translated(size_t row_offset, size_t col_offset) const {
-    Frame<Ts> result;
-    for (size_t row = 0; row < Ts; ++row) {
-        const size_t new_row = (row + row_offset) % Ts;
-        for (size_t col = 0; col < Ts; ++col) {
-            const size_t new_col = (col + col_offset) % Ts;
-            result.set(row, col, get(new_row, new_col));
-        }
-    }
-    return result;
+requires(Ts <= 16)constexpr Frame<Ts> Frame<Ts>::translated(size_t row_offset, size_t col_offset) const {
+    return Frame<Ts>(translate_cols(translate_rows(m_state, row_offset), col_offset));
 }
 
 template<size_t Ts>
-requires(Ts <= 11)
+requires(Ts <= 16)
 template<bool Horizontal, bool Vertical>
 constexpr Frame<Ts> Frame<Ts>::flipped() const {
     if constexpr (!Horizontal && !Vertical)
         return get();
 
-    Frame<Ts> result;
-    bool cell_value;
-    for (size_t row = 0; row < Ts; ++row) {
-        for (size_t col = 0; col < Ts; ++col) {
-            if (Horizontal && !Vertical)
-                cell_value = get(Ts - 1 - row, col);
-
-            else if (!Horizontal && Vertical)
-                cell_value = get(row, Ts - col - 1);
-
-            else // Both are true
-                cell_value = get(Ts - 1 - row, Ts - col - 1);
-
-            result.set(row, col, cell_value);
-        }
-    }
-    return Frame<Ts>(result);
+    constexpr size_t transform_index = Horizontal && Vertical ? 4 : (Horizontal ? 5 : 1);
+    return from_rows(transform_rows(rows(), transform_index));
 }
 
 template<size_t Ts>
-requires(Ts <= 11)
+requires(Ts <= 16)
 template<bool Anti>
 constexpr Frame<Ts> Frame<Ts>::transposed() const {
-    Frame<Ts> result;
-    bool cell_value;
-    for (size_t row = 0; row < Ts; ++row) {
-        for (size_t col = 0; col < Ts; ++col) {
-            if constexpr (Anti)
-                cell_value = get(Ts - 1 - col, Ts - 1 - row);
-
-            else
-                cell_value = get(col, row);
-
-            result.set(row, col, cell_value);
-        }
-    }
-    return result;
+    return from_rows(transform_rows(rows(), Anti ? 2 : 6));
 }
 
 template<size_t Ts>
-requires(Ts <= 11)
+requires(Ts <= 16)
 template<size_t Tid>
 requires(Tid < 8)
 constexpr Frame<Ts> Frame<Ts>::transformed() const {
@@ -262,49 +421,83 @@ constexpr Frame<Ts> Frame<Ts>::transformed() const {
 }
 
 template<size_t Ts>
-requires(Ts <= 11)
+requires(Ts <= 16)
 template<bool Tcw>
 constexpr Frame<Ts> Frame<Ts>::rotated() const {
-    Frame<Ts> result;
-    bool cell_value;
-    for (size_t row = 0; row < Ts; ++row) {
-        for (size_t col = 0; col < Ts; ++col) {
-            if constexpr (Tcw)
-                cell_value = get(Ts - 1 - col , row);
+    return from_rows(transform_rows(rows(), Tcw ? 3 : 7));
+}
 
-            else
-                cell_value = get(col, Ts - 1 - row );
+template<size_t Ts>
+requires(Ts <= 16)constexpr Frame<Ts> Frame<Ts>::transformed(size_t transform_index) const {
+    return from_rows(transform_rows(rows(), transform_index));
+}
 
-            result.set(row, col, cell_value);
-        }
+template<size_t Ts>
+requires(Ts <= 16)constexpr typename Frame<Ts>::Rows Frame<Ts>::rows() const {
+    Rows rows{};
+    for (size_t row = 0; row < Ts; ++row) {
+        rows[row] = static_cast<uint16_t>(static_cast<uint64_t>(m_state >> (row * Ts)) & RowMask);
     }
-    return result;
+    return rows;
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr Frame<Ts> Frame<Ts>::transformed(size_t transform_index) const {
-    if (0 == transform_index) {
-        return Frame<Ts>(get());
-    } else if (1 == transform_index) {
-        return flipped<false, true>();
-    } else if (2 == transform_index) {
-        return transposed<true>();
-    } else if (3 == transform_index) {
-        return rotated<true>();
-    } else if (4 == transform_index) {
-        return flipped<true, true>();
-    } else if (5 == transform_index) {
-        return flipped<true, false>();
-    } else if (6 == transform_index) {
-        return transposed<false>();
-    } else if (7 == transform_index) {
-        return rotated<false>();
+requires(Ts <= 16)constexpr Frame<Ts> Frame<Ts>::from_rows(const Rows &rows) {
+    State state = 0;
+    for (size_t row = 0; row < Ts; ++row) {
+        state = state | (State(rows[row]) << (row * Ts));
+    }
+    return Frame<Ts>(state);
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr uint16_t Frame<Ts>::rotate_row(uint16_t row, size_t offset) {
+    const size_t shift = offset % Ts;
+    return static_cast<uint16_t>(((row >> shift) | (row << (Ts - shift))) & RowMask);
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr typename Frame<Ts>::Rows Frame<Ts>::transform_rows(const Rows &rows, size_t transform_index) {
+    const auto reverse_cols = [](const Rows &source) {
+        Rows result{};
+        for (size_t row = 0; row < Ts; ++row)
+            result[row] = row_reverse_lookup[source[row]];
+        return result;
+    };
+
+    const auto reverse_rows = [](const Rows &source) {
+        Rows result{};
+        for (size_t row = 0; row < Ts; ++row)
+            result[row] = source[Ts - 1 - row];
+        return result;
+    };
+
+    const auto transpose = [](const Rows &source) {
+        State state = 0;
+        for (size_t row = 0; row < Ts; ++row) {
+            for (size_t chunk = 0; chunk < Ts; chunk += RowChunkBits) {
+                const size_t bits = (source[row] >> chunk) & ((1u << RowChunkBits) - 1);
+                state = state | (row_transpose_lookup[bits] << (chunk * Ts + row));
+            }
+        }
+        return Frame<Ts>(state).rows();
+    };
+
+    switch (transform_index) {
+        case 1: return reverse_cols(rows);
+        case 2: return transpose(reverse_rows(reverse_cols(rows)));
+        case 3: return transpose(reverse_rows(rows));
+        case 4: return reverse_rows(reverse_cols(rows));
+        case 5: return reverse_rows(rows);
+        case 6: return transpose(rows);
+        case 7: return transpose(reverse_cols(rows));
+        default: return rows;
     }
 }
 
 template<size_t N>
-requires(N <= 11) constexpr absl::uint128 Frame<N>::get_neighbour_mask(size_t cell_row, size_t cell_col) {
-    absl::uint128 mask = 0;
+requires(N <= 16) constexpr typename Frame<N>::State Frame<N>::get_neighbour_mask(size_t cell_row, size_t cell_col) {
+    State mask = 0;
     for (int i = -1; i < 2; ++i) {
         const size_t row = (N + cell_row + i) % N;
 
@@ -314,7 +507,7 @@ requires(N <= 11) constexpr absl::uint128 Frame<N>::get_neighbour_mask(size_t ce
                 continue;
 
             const size_t col = (N + cell_col + j) % N;
-            absl::uint128 bitmask = 1;
+            State bitmask = 1;
             bitmask = bitmask << index_lookup[row][col];
             mask = mask | bitmask;
         }
@@ -323,9 +516,9 @@ requires(N <= 11) constexpr absl::uint128 Frame<N>::get_neighbour_mask(size_t ce
 }
 
 template<size_t N>
-requires(N <= 11)
-constexpr std::array<absl::uint128, Frame<N>::CellCount> Frame<N>::create_neighbour_mask_lut() {
-    std::array<absl::uint128, CellCount> table{};
+requires(N <= 16)
+constexpr std::array<typename Frame<N>::State, Frame<N>::CellCount> Frame<N>::create_neighbour_mask_lut() {
+    std::array<State, CellCount> table{};
     for (size_t row = 0; row < N; ++row) {
         for (size_t col = 0; col < N; ++col) {
             auto index = to_index(row, col);
@@ -336,7 +529,7 @@ constexpr std::array<absl::uint128, Frame<N>::CellCount> Frame<N>::create_neighb
 }
 
 template<size_t Ts>
-requires(Ts <= 11)constexpr std::array<std::array<size_t, Ts>, Ts> Frame<Ts>::create_index_lut() {
+requires(Ts <= 16)constexpr std::array<std::array<size_t, Ts>, Ts> Frame<Ts>::create_index_lut() {
     std::array<std::array<size_t, Ts>, Ts> table{};
 
     for (size_t row = 0; row < Ts; ++row) {
@@ -348,6 +541,82 @@ requires(Ts <= 11)constexpr std::array<std::array<size_t, Ts>, Ts> Frame<Ts>::cr
     return table;
 }
 
+template<size_t Ts>
+requires(Ts <= 16)constexpr std::array<typename Frame<Ts>::State, Ts + 1> Frame<Ts>::create_column_mask_lut() {
+    std::array<State, Ts + 1> table{};
+
+    for (size_t count = 0; count <= Ts; ++count) {
+        State mask = 0;
+        for (size_t row = 0; row < Ts; ++row) {
+            for (size_t col = 0; col < count; ++col) {
+                mask = mask | (State(1) << to_index(row, col));
+            }
+        }
+        table[count] = mask;
+    }
+
+    return table;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr std::array<uint16_t, 1 << Ts> Frame<Ts>::create_row_reverse_lut() {
+    std::array<uint16_t, 1 << Ts> table{};
+
+    // Reversing row drops its lowest bit off the reversal of row >> 1 and puts it in front,
+    // one step per entry keeps the 16x16 table within the constexpr evaluation limits.
+    for (size_t row = 1; row < table.size(); ++row) {
+        table[row] = static_cast<uint16_t>((table[row >> 1] >> 1) | ((row & 1u) << (Ts - 1)));
+    }
+
+    return table;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr std::array<uint16_t, 1 << Ts> Frame<Ts>::create_row_min_rotation_lut() {
+    std::array<uint16_t, 1 << Ts> table{};
+
+    // Rows are visited in ascending order, so the first row of every rotation class met is its
+    // smallest member and the whole class is filled at once. Only row 0 has the minimum 0.
+    for (size_t row = 1; row < table.size(); ++row) {
+        if (table[row] != 0)
+            continue;
+        for (size_t offset = 0; offset < Ts; ++offset) {
+            table[rotate_row(static_cast<uint16_t>(row), offset)] = static_cast<uint16_t>(row);
+        }
+    }
+
+    return table;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr std::array<typename Frame<Ts>::State, 1 << Frame<Ts>::RowChunkBits> Frame<Ts>::create_row_transpose_lut() {
+    std::array<State, 1 << RowChunkBits> table{};
+
+    for (size_t row = 0; row < table.size(); ++row) {
+        State column = 0;
+        for (size_t col = 0; col < RowChunkBits; ++col) {
+            if (row & (1u << col))
+                column = column | (State(1) << to_index(col, 0));
+        }
+        table[row] = column;
+    }
+
+    return table;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr typename Frame<Ts>::State Frame<Ts>::translate_rows(State state, size_t offset) {
+    const size_t shift = (offset % Ts) * Ts;
+    return ((state >> shift) | (state << (CellCount - shift))) & BoardMask;
+}
+
+template<size_t Ts>
+requires(Ts <= 16)constexpr typename Frame<Ts>::State Frame<Ts>::translate_cols(State state, size_t offset) {
+    const size_t shift = offset % Ts;
+    const State kept = column_mask_lookup[Ts - shift];
+    return ((state >> shift) & kept) | ((state << (Ts - shift)) & ~kept & BoardMask);
+}
+
 template<size_t N>
 std::ostream &operator<<(std::ostream &os, const Frame<N> &frame) {
     for(size_t i = 0; i < frame.CellCount; ++i)
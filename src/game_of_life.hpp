@@ -1,8 +1,16 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <span>
 #include <unordered_map>
+#include <vector>
+#include <bitsliced_batch.hpp>
 #include <cycle.hpp>
+#include <cycle_memo.hpp>
 #include <frame.hpp>
+#include <instrumentation.hpp>
 
 template<size_t Ts>
 class GameOfLife
@@ -16,12 +24,52 @@ private:
         { false, false, true , true, false, false, false, false, false }
     };
 
+    using State = typename Frame<Ts>::State;
+
     Frame<Ts> m_frame;
 
     size_t m_generation;
 
+    constexpr static std::array<size_t, Frame<Ts>::CellCount> all_cells = []
+    {
+        std::array<size_t, Frame<Ts>::CellCount> cells{};
+        for (size_t i = 0; i < cells.size(); ++i)
+            cells[i] = i;
+        return cells;
+    }();
+
+    constexpr static void half_add(
+        State a, State b,
+        State &sum, State &carry)
+    {
+        sum = a ^ b;
+        carry = a & b;
+    }
+
+    constexpr static void full_add(
+        State a, State b, State c,
+        State &sum, State &carry)
+    {
+        const State partial = a ^ b;
+        sum = partial ^ c;
+        carry = (a & b) | (partial & c);
+    }
+
 public:
 
+    /// @brief Outcomes of every single cell perturbation of every frame of a cycle.
+    struct PerturbationSweep
+    {
+        /// @brief Cycles reached by the simulated perturbations.
+        std::vector<Cycle<Ts>> cycles;
+
+        /// @brief Element f * CellCount + c indexes the cycle reached after toggling cell c of frame f.
+        std::vector<uint32_t> outcomes;
+
+        /// @brief Number of perturbations that were actually simulated.
+        size_t simulated = 0;
+    };
+
     constexpr GameOfLife()
     : m_frame(0)
     , m_generation(0)
@@ -36,25 +84,60 @@ public:
 
     }
 
+    /// @brief Compute the next generation of the whole torus at once.
+    /// The eight neighbour planes are built with row and column rotations of the packed
+    /// state and summed bit-parallel with carry-save adders, then B3/S23 is applied.
+    /// @return Next frame.
     [[nodiscard]] constexpr Frame<Ts> next() const
+    {
+        const State state = m_frame.get();
+
+        const State above = Frame<Ts>::translate_rows(state, Ts - 1);
+        const State below = Frame<Ts>::translate_rows(state, 1);
+
+        const State n0 = Frame<Ts>::translate_cols(state, 1);
+        const State n1 = Frame<Ts>::translate_cols(state, Ts - 1);
+        const State n2 = above;
+        const State n3 = Frame<Ts>::translate_cols(above, 1);
+        const State n4 = Frame<Ts>::translate_cols(above, Ts - 1);
+        const State n5 = below;
+        const State n6 = Frame<Ts>::translate_cols(below, 1);
+        const State n7 = Frame<Ts>::translate_cols(below, Ts - 1);
+
+        // Ones column of the neighbour count.
+        State s0, c0, s1, c1, s2, c2;
+        full_add(n0, n1, n2, s0, c0);
+        full_add(n3, n4, n5, s1, c1);
+        half_add(n6, n7, s2, c2);
+
+        State ones, c3;
+        full_add(s0, s1, s2, ones, c3);
+
+        // Twos column, any carry out of it means four or more neighbours.
+        State t0, c4, twos, c5;
+        full_add(c0, c1, c2, t0, c4);
+        half_add(t0, c3, twos, c5);
+
+        const State alive = twos & ~(c4 | c5) & (ones | state);
+
+        return Frame<Ts>(alive & Frame<Ts>::BoardMask);
+    }
+
+    /// @brief Compute the next generation cell by cell using the neighbour mask lookup.
+    /// Kept as the reference implementation for the bit-parallel step.
+    /// @return Next frame.
+    [[nodiscard]] constexpr Frame<Ts> next_reference() const
     {
         Frame<Ts> next;
         for(size_t i = 0; i < Frame<Ts>::CellCount; ++i)
         {
             const size_t n = m_frame.neighbour_cnt(i);
             const bool alive = m_frame.get(i);
-
-            //std:: cout << n;
-
-            //if((i + 1) % N == 0)
-                //std::cout << '\n';
             const bool a = alive_lookup[alive][n];
 
             next.set(i, a);
         }
 
-        //std::cout << '\n';
-
         return next;
     }
 
@@ -80,10 +163,143 @@ public:
         m_generation = 0;
     }
 
+    /// @brief Count one cycle search for the instrumentation report.
+    /// @param generations Generations evolved in total.
+    /// @param transient Generations evolved until the cycle was detected or a memoized frame was reached.
+    /// @param period Period of the cycle the search ended up in.
+    constexpr static void record_search(uint64_t generations, uint64_t transient, uint64_t period)
+    {
+        instrumentation::count(instrumentation::Counter::FindCycleCalls);
+        instrumentation::count(instrumentation::Counter::Generations, generations);
+        instrumentation::record(instrumentation::Histogram::Transient, transient);
+        instrumentation::record(instrumentation::Histogram::Period, period);
+    }
+
+    /// @brief Find the cycle that the current frame ends up in using Brent's algorithm.
+    /// Memory use is constant, the frames of the found period are walked once to build the cycle.
+    /// @param cycle_frames Scratch buffer for the cycle frames, cleared before returning.
+    /// @return Cycle the current frame ends up in.
+    [[nodiscard]] constexpr Cycle<Ts> find_cycle(std::vector<Frame<Ts>> &cycle_frames)
+    {
+        const size_t start_generation = m_generation;
+        Frame<Ts> tortoise = m_frame;
+        size_t power = 1;
+        size_t period = 1;
+
+        evolve();
+        while (!(tortoise == m_frame))
+        {
+            if (power == period)
+            {
+                tortoise = m_frame;
+                power *= 2;
+                period = 0;
+            }
+            evolve();
+            ++period;
+        }
+
+        // Collecting the cycle frames below takes another period - 1 generations.
+        const size_t transient = m_generation - start_generation;
+        record_search(transient + period - 1, transient, period);
+
+        // Still lifes and blinkers dominate, build them without the scratch buffer.
+        if (1 == period)
+        {
+            const std::array<Frame<Ts>, 1> frames { m_frame };
+            return Cycle<Ts>(frames);
+        }
+
+        if (2 == period)
+        {
+            const std::array<Frame<Ts>, 2> frames { m_frame, next() };
+            return Cycle<Ts>(frames);
+        }
+
+        cycle_frames.push_back(m_frame);
+        for (size_t i = 1; i < period; ++i)
+        {
+            evolve();
+            cycle_frames.push_back(m_frame);
+        }
+
+        Cycle<Ts> cycle(cycle_frames);
+        cycle_frames.clear();
+        return cycle;
+    }
+
+    /// @brief Find the cycle that the current frame ends up in, stopping at the first memoized frame.
+    /// Every frame visited on the way is back-filled into the memo with the answer.
+    /// @param memo Memo shared across calls.
+    /// @param trajectory Scratch buffer for the visited frames, cleared before returning.
+    /// @return Index of the cycle in the memo.
+    [[nodiscard]] size_t find_cycle(CycleMemo<Ts> &memo, std::vector<Frame<Ts>> &trajectory)
+    {
+        const size_t start_generation = m_generation;
+        Frame<Ts> tortoise = m_frame;
+        size_t power = 1;
+        size_t period = 1;
+
+        std::optional<size_t> cycle_index = memo.find(m_frame);
+        if (cycle_index)
+        {
+            record_search(0, 0, memo.cycle(*cycle_index).frames().size());
+            return *cycle_index;
+        }
+
+        trajectory.push_back(m_frame);
+        evolve();
+        while (!(tortoise == m_frame))
+        {
+            cycle_index = memo.find(m_frame);
+            if (cycle_index)
+                break;
+
+            trajectory.push_back(m_frame);
+            if (power == period)
+            {
+                tortoise = m_frame;
+                power *= 2;
+                period = 0;
+            }
+            evolve();
+            ++period;
+        }
+
+        const size_t transient = m_generation - start_generation;
+        if (!cycle_index)
+        {
+            // The trajectory closed on itself, walk the period once to collect the cycle frames.
+            const size_t cycle_begin = trajectory.size();
+            trajectory.push_back(m_frame);
+            for (size_t i = 1; i < period; ++i)
+            {
+                evolve();
+                trajectory.push_back(m_frame);
+            }
+
+            const std::span<const Frame<Ts>> cycle_frames(trajectory.begin() + cycle_begin, trajectory.end());
+            cycle_index = memo.add_cycle(Cycle<Ts>(cycle_frames));
+        }
+
+        record_search(m_generation - start_generation, transient, memo.cycle(*cycle_index).frames().size());
+
+        for (const auto& frame : trajectory)
+            memo.insert(frame, *cycle_index);
+
+        trajectory.clear();
+        return *cycle_index;
+    }
+
+    /// @brief Find the cycle that the current frame ends up in by remembering every visited frame.
+    /// @param visited_frames Scratch lookup of visited frames, cleared before returning.
+    /// @param cycle_frames Scratch buffer for the cycle frames, cleared before returning.
+    /// @return Cycle the current frame ends up in.
     [[nodiscard]] constexpr Cycle<Ts> find_cycle(
             std::unordered_map<Frame<Ts>, size_t, typename Frame<Ts>::Hash> &visited_frames,
             std::vector<Frame<Ts>> &cycle_frames)
     {
+        const size_t start_generation = m_generation;
         visited_frames.insert({ m_frame, m_generation });
     
         for(;;)
@@ -92,6 +308,7 @@ public:
             if(visited_frames.contains(m_frame))
             {
                 size_t cycle_begin_generation = visited_frames[m_frame];
+                record_search(m_generation - start_generation, m_generation - start_generation, m_generation - cycle_begin_generation);
 
                 for (const auto& [frame, generation] : visited_frames) {
                     if(generation >= cycle_begin_generation)
@@ -111,50 +328,246 @@ public:
         }
     }
 
-    std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> find_cycles(
+    /// @brief Find the cycles reached after toggling each cell of a frame.
+    /// @tparam Word lane word of the batch.
+    /// @param frame Frame to perturb.
+    /// @return Element i is the cycle reached after toggling cell i.
+    template<class Word = DefaultLaneWord>
+    [[nodiscard]] static std::vector<Cycle<Ts>> perturb_all(const Frame<Ts> &frame)
+    {
+        return perturb<Word>(frame, all_cells);
+    }
+
+    /// @brief Find the cycles reached after toggling some of the cells of a frame.
+    /// All perturbed frames advance together in a bit-sliced batch running Brent's algorithm in
+    /// lockstep, a lane retires as soon as its tortoise and hare meet.
+    /// @tparam Word lane word of the batch.
+    /// @param frame Frame to perturb.
+    /// @param cells Cells to toggle one at a time.
+    /// @return Element i is the cycle reached after toggling cells[i].
+    template<class Word = DefaultLaneWord>
+    [[nodiscard]] static std::vector<Cycle<Ts>> perturb(const Frame<Ts> &frame, std::span<const size_t> cells)
+    {
+        using Batch = BitslicedBatch<Ts, Word>;
+        constexpr size_t Parts = (Batch::Lanes + 63) / 64;
+
+        std::vector<Cycle<Ts>> cycles(cells.size());
+        std::vector<Frame<Ts>> cycle_frames;
+        GameOfLife<Ts> game;
+
+        // Frames of the cycles found so far, mapped to a cell that reached them.
+        std::unordered_map<Frame<Ts>, size_t, typename Frame<Ts>::Hash> known_cycles;
+
+        for (size_t first_cell = 0; first_cell < cells.size(); first_cell += Batch::Lanes)
+        {
+            const size_t lane_count = std::min(Batch::Lanes, cells.size() - first_cell);
+
+            Batch hare;
+            std::array<u64, Parts> active{};
+            for (size_t lane = 0; lane < lane_count; ++lane)
+            {
+                Frame<Ts> perturbed = frame;
+                perturbed.toggle(cells[first_cell + lane]);
+                hare.set(lane, perturbed);
+                active[lane / 64] |= u64(1) << (lane % 64);
+            }
+
+            // Every lane takes the same number of steps, so the tortoise jumps at the same time in all of them.
+            Batch tortoise = hare;
+            size_t power = 1;
+            size_t period = 1;
+            size_t remaining = lane_count;
+            size_t steps = 1;
+
+            hare.evolve();
+            for (;;)
+            {
+                std::array<u64, Parts> differing{};
+                Batch::Traits::store(hare.differing_lanes(tortoise), differing.data());
+
+                for (size_t part = 0; part < Parts; ++part)
+                {
+                    u64 met = active[part] & ~differing[part];
+                    active[part] &= ~met;
+
+                    for (; met != 0; met &= met - 1)
+                    {
+                        const size_t lane = part * 64 + std::countr_zero(met);
+                        instrumentation::record(instrumentation::Histogram::Transient, steps);
+                        instrumentation::record(instrumentation::Histogram::Period, period);
+
+                        // Perturbations mostly share a few destinations, only normalize cycles not seen yet.
+                        const Frame<Ts> on_cycle = hare.frame(lane);
+                        const auto known = known_cycles.find(on_cycle);
+                        if (known != known_cycles.end())
+                        {
+                            cycles[first_cell + lane] = cycles[known->second];
+                        }
+                        else
+                        {
+                            // The hare sits on the cycle, walking the period once collects its frames.
+                            game.set(on_cycle);
+                            instrumentation::count(instrumentation::Counter::Generations, period);
+                            for (size_t i = 0; i < period; ++i)
+                            {
+                                cycle_frames.push_back(game.frame());
+                                known_cycles.emplace(game.frame(), first_cell + lane);
+                                game.evolve();
+                            }
+                            cycles[first_cell + lane] = Cycle<Ts>(cycle_frames);
+                            cycle_frames.clear();
+                        }
+                        --remaining;
+                    }
+                }
+
+                if (0 == remaining)
+                    break;
+
+                if (power == period)
+                {
+                    tortoise = hare;
+                    power *= 2;
+                    period = 0;
+                }
+                hare.evolve();
+                ++period;
+                ++steps;
+            }
+
+            instrumentation::count(instrumentation::Counter::FindCycleCalls, lane_count);
+            instrumentation::count(instrumentation::Counter::Generations, steps * lane_count);
+        }
+
+        return cycles;
+    }
+
+    CycleSet<Ts> find_cycles(
         size_t samples,
         size_t sample_length)
     {
-        // Reuse containers to avoid instantiation.
+        CycleMemo<Ts> memo;
+        return find_cycles(samples, sample_length, memo);
+    }
 
-        // Used as a lookup to check if frame has been visited
-        std::unordered_map<Frame<Ts>, size_t, typename Frame<Ts>::Hash> visited_frames;
+    CycleSet<Ts> find_cycles(
+        size_t samples,
+        size_t sample_length,
+        CycleMemo<Ts> &memo)
+    {
+        // Reuse containers to avoid instantiation.
 
-        // Cycle frames are accumulated.
-        std::vector<Frame<Ts>> cycle_frames;
+        // Visited frames are accumulated.
+        std::vector<Frame<Ts>> trajectory;
 
         // Resulting cycles
-        std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> cycles;
+        CycleSet<Ts> cycles;
 
-        const size_t space_length = Frame<Ts>::States / samples - sample_length;
+        // States wraps to zero for 16x16, leaving out the last state does not matter there.
+        const State states = Frame<Ts>::States ? Frame<Ts>::States : Frame<Ts>::BoardMask;
+        const State space_length = states / samples - sample_length;
 
         // Sample evenly spaced intervals
         for(size_t sample_index = 0; sample_index < samples; ++sample_index)
         {
-            const uint64_t start_state = sample_index * (space_length + sample_length);
+            const State start_state = sample_index * (space_length + sample_length);
 
-            for(uint64_t state = start_state; state < start_state + sample_length; ++state)
+            for(State state = start_state; state < start_state + sample_length; ++state)
             {
                 set(Frame<Ts>(state));
-                const auto cycle = find_cycle(visited_frames, cycle_frames);
-                cycles.insert(cycle);
+                const size_t cycle_index = find_cycle(memo, trajectory);
+                cycles.insert(memo.cycle(cycle_index));
             }
         }
 
         return cycles;
     }
 
+    /// @brief Find the cycles reached after toggling each cell of each frame of a cycle, simulating
+    /// only one perturbation per symmetry class. Translations and D4 transforms commute with next(),
+    /// so toggling cell c of frame f reaches the same normalized cycle as toggling the image of c in
+    /// the matching image of f. Frames that normalize to the same frame, like the phases of a glider,
+    /// share their simulations, and cells of a normalized frame that its stabilizer maps onto each
+    /// other are simulated once.
+    /// @param frames Frames of the cycle.
+    /// @return Sweep with an outcome for every cell of every frame.
+    [[nodiscard]] static PerturbationSweep perturb_cycle(std::span<const Frame<Ts>> frames)
+    {
+        PerturbationSweep sweep;
+        sweep.outcomes.resize(frames.size() * Frame<Ts>::CellCount);
+
+        // Outcome of every cell of each distinct normalized frame.
+        std::unordered_map<Frame<Ts>, std::array<uint32_t, Frame<Ts>::CellCount>, typename Frame<Ts>::Hash> normalized_outcomes;
+
+        for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index)
+        {
+            Transform transform;
+            const Frame<Ts> normalized = frames[frame_index].normalized(transform);
+
+            auto known = normalized_outcomes.find(normalized);
+            if (known == normalized_outcomes.end())
+            {
+                // The stabilizer is a group, so the orbit of a cell is its image under every element.
+                const auto stabilizer = normalized.stabilizer();
+                std::array<size_t, Frame<Ts>::CellCount> representative;
+                representative.fill(Frame<Ts>::CellCount);
+                std::vector<size_t> cells;
+                for (size_t cell = 0; cell < Frame<Ts>::CellCount; ++cell)
+                {
+                    if (representative[cell] != Frame<Ts>::CellCount)
+                        continue;
+                    for (const auto &element : stabilizer)
+                        representative[Frame<Ts>::transformed_cell(cell, element)] = cells.size();
+                    cells.push_back(cell);
+                }
+
+                const auto first = static_cast<uint32_t>(sweep.cycles.size());
+                for (auto &cycle : perturb(normalized, cells))
+                    sweep.cycles.push_back(std::move(cycle));
+                sweep.simulated += cells.size();
+
+                std::array<uint32_t, Frame<Ts>::CellCount> outcomes;
+                for (size_t cell = 0; cell < Frame<Ts>::CellCount; ++cell)
+                    outcomes[cell] = first + static_cast<uint32_t>(representative[cell]);
+                known = normalized_outcomes.emplace(normalized, outcomes).first;
+            }
+
+            for (size_t cell = 0; cell < Frame<Ts>::CellCount; ++cell)
+            {
+                sweep.outcomes[frame_index * Frame<Ts>::CellCount + cell] =
+                    known->second[Frame<Ts>::transformed_cell(cell, transform)];
+            }
+        }
+
+        return sweep;
+    }
+
     [[nodiscard]]
-    std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> search_perturbed(
-        std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> cycles)
+    CycleSet<Ts> search_perturbed(
+        CycleSet<Ts> cycles)
+    {
+        // Given cycles + cycles that were found by perturbing each frame from given cycles
+        CycleSet<Ts> total_cycles = cycles;
+
+        for (auto const& cycle : cycles)
+        {
+            for (auto& perturbed_cycle : perturb_cycle(cycle.frames()).cycles)
+                total_cycles.insert(std::move(perturbed_cycle));
+        }
+
+        return total_cycles;
+    }
+
+    [[nodiscard]]
+    CycleSet<Ts> search_perturbed(
+        CycleSet<Ts> const& cycles,
+        CycleMemo<Ts> &memo)
     {
         // Reuse containers to avoid instantiation.
-        // Used as a lookup to check if frame has been visited
-        std::unordered_map<Frame<Ts>, size_t, typename Frame<Ts>::Hash> visited_frames;
-        // Cycle frames are accumulated.
-        std::vector<Frame<Ts>> cycle_frames;
+        // Visited frames are accumulated.
+        std::vector<Frame<Ts>> trajectory;
         // Given cycles + cycles that were found by perturbing each frame from given cycles
-        std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> total_cycles;
+        CycleSet<Ts> total_cycles;
 
         // Copy existing cycles
         for (auto const& cycle : cycles)
@@ -169,8 +582,8 @@ public:
                     Frame<Ts> frame = org_frame;
                     frame.toggle(i);
                     set(frame);
-                    auto perturbed_cycle = find_cycle(visited_frames, cycle_frames);
-                    total_cycles.insert(perturbed_cycle);
+                    const size_t cycle_index = find_cycle(memo, trajectory);
+                    total_cycles.insert(memo.cycle(cycle_index));
                 }
             }
         }
@@ -179,16 +592,28 @@ public:
     }
 
     [[nodiscard]]
-    static std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> search_perturbed(
+    static CycleSet<Ts> search_perturbed(
         Cycle<Ts> const & cycle)
+    {
+        // Cycles that were found by perturbing each frame from given cycles
+        CycleSet<Ts> cycles;
+
+        for (auto& perturbed_cycle : perturb_cycle(cycle.frames()).cycles)
+            cycles.insert(std::move(perturbed_cycle));
+
+        return cycles;
+    }
+
+    [[nodiscard]]
+    static CycleSet<Ts> search_perturbed(
+        Cycle<Ts> const & cycle,
+        CycleMemo<Ts> &memo)
     {
         // Reuse containers to avoid instantiation.
-        // Used as a lookup to check if frame has been visited
-        std::unordered_map<Frame<Ts>, size_t, typename Frame<Ts>::Hash> visited_frames;
-        // Cycle frames are accumulated.
-        std::vector<Frame<Ts>> cycle_frames;
+        // Visited frames are accumulated.
+        std::vector<Frame<Ts>> trajectory;
         // Cycles that were found by perturbing each frame from given cycles
-        std::unordered_set<Cycle<Ts>, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> cycles;
+        CycleSet<Ts> cycles;
 
         GameOfLife<Ts> game;
 
@@ -199,8 +624,8 @@ public:
                 Frame<Ts> frame = org_frame;
                 frame.toggle(i);
                 game.set(frame);
-                auto perturbed_cycle = game.find_cycle(visited_frames, cycle_frames);
-                cycles.insert(perturbed_cycle);
+                const size_t cycle_index = game.find_cycle(memo, trajectory);
+                cycles.insert(memo.cycle(cycle_index));
             }
         }
 
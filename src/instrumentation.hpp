@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include <resource_usage.hpp>
+
+/// @brief Counters, histograms and timers of the hot paths. Every thread counts into a slot of its
+/// own, slots are handed back when a thread exits and reused by the next one, so the workers of
+/// consecutive scheduler runs add up in the same slots and appear as the same rows of a trace.
+/// Configure with -DGOLC_INSTRUMENTATION=ON to compile them in, otherwise counting and tracing are
+/// no-ops. Phases run a handful of times per run, so their totals are always recorded.
+namespace instrumentation
+{
+
+#if defined(GOLC_INSTRUMENTATION)
+constexpr bool Enabled = true;
+#else
+constexpr bool Enabled = false;
+#endif
+
+enum class Counter : size_t
+{
+    /// @brief Board generations evolved by cycle searches, a batch counts every lane.
+    Generations,
+
+    /// @brief Cycle searches, a batch counts every lane.
+    FindCycleCalls,
+
+    Normalizations,
+
+    /// @brief Lookups in the cycle memo and the concurrent cycle set.
+    HashLookups,
+
+    /// @brief Slots inspected by those lookups.
+    HashProbes,
+
+    MemoLookups,
+
+    MemoHits
+};
+
+constexpr size_t CounterCount = 7;
+
+constexpr std::array<std::string_view, CounterCount> CounterNames {
+    "generations", "find_cycle_calls", "normalizations", "hash_lookups", "hash_probes", "memo_lookups", "memo_hits"
+};
+
+enum class Histogram : size_t
+{
+    /// @brief Generations a search evolved until it detected its cycle or reached a memoized frame,
+    /// for Brent's algorithm that is the transient plus up to two periods.
+    Transient,
+
+    /// @brief Period of the cycle a search ended up in.
+    Period
+};
+
+constexpr size_t HistogramCount = 2;
+
+constexpr std::array<std::string_view, HistogramCount> HistogramNames { "transient", "period" };
+
+/// @brief Bucket 0 holds zero and bucket b > 0 holds [2^(b-1), 2^b).
+constexpr size_t BucketCount = 65;
+
+/// @brief Complete event of the trace timeline.
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+};
+
+struct alignas(64) ThreadSlot
+{
+    size_t index = 0;
+
+    std::array<std::atomic<uint64_t>, CounterCount> counters{};
+
+    std::array<std::array<std::atomic<uint64_t>, BucketCount>, HistogramCount> histograms{};
+
+    std::vector<TraceEvent> events;
+};
+
+/// @brief Total time of every phase with the same name.
+struct PhaseTotal
+{
+    std::string_view name;
+    uint64_t calls = 0;
+    std::chrono::nanoseconds elapsed { 0 };
+};
+
+class Registry
+{
+
+private:
+
+    std::mutex m_mutex;
+
+    std::vector<std::unique_ptr<ThreadSlot>> m_slots;
+
+    std::vector<ThreadSlot*> m_free;
+
+    std::vector<PhaseTotal> m_phases;
+
+    std::atomic<bool> m_trace = false;
+
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+
+public:
+
+    [[nodiscard]] ThreadSlot* acquire()
+    {
+        std::lock_guard lock(m_mutex);
+        if (!m_free.empty())
+        {
+            // Reuse the lowest free slot so worker i of every run keeps landing in the same row.
+            const auto lowest = std::ranges::min_element(m_free, {}, &ThreadSlot::index);
+            ThreadSlot *slot = *lowest;
+            m_free.erase(lowest);
+            return slot;
+        }
+
+        m_slots.push_back(std::make_unique<ThreadSlot>());
+        m_slots.back()->index = m_slots.size() - 1;
+        return m_slots.back().get();
+    }
+
+    void release(ThreadSlot *slot)
+    {
+        std::lock_guard lock(m_mutex);
+        m_free.push_back(slot);
+    }
+
+    void add_phase(std::string_view name, std::chrono::nanoseconds elapsed)
+    {
+        std::lock_guard lock(m_mutex);
+        auto phase = std::ranges::find(m_phases, name, &PhaseTotal::name);
+        if (phase == m_phases.end())
+        {
+            m_phases.push_back({ name });
+            phase = m_phases.end() - 1;
+        }
+        ++phase->calls;
+        phase->elapsed += elapsed;
+    }
+
+    [[nodiscard]] bool trace() const
+    {
+        return m_trace.load(std::memory_order_relaxed);
+    }
+
+    void set_trace(bool enabled)
+    {
+        m_trace = enabled;
+    }
+
+    /// @brief Write the totals, per thread counters, histograms and phases as JSON. Threads that still
+    /// count while this runs may be reported slightly behind.
+    void write_report(std::ostream &os)
+    {
+        std::lock_guard lock(m_mutex);
+
+        std::array<uint64_t, CounterCount> totals{};
+        std::array<std::array<uint64_t, BucketCount>, HistogramCount> histograms{};
+        for (const auto &slot : m_slots)
+        {
+            for (size_t i = 0; i < CounterCount; ++i)
+                totals[i] += slot->counters[i].load(std::memory_order_relaxed);
+            for (size_t h = 0; h < HistogramCount; ++h)
+                for (size_t b = 0; b < BucketCount; ++b)
+                    histograms[h][b] += slot->histograms[h][b].load(std::memory_order_relaxed);
+        }
+
+        const auto write_counters = [&](const auto &values)
+        {
+            os << "{ ";
+            for (size_t i = 0; i < CounterCount; ++i)
+                os << '"' << CounterNames[i] << "\": " << uint64_t(values[i]) << (i + 1 < CounterCount ? ", " : " }");
+        };
+
+        os << "{\n";
+        os << "  \"instrumentation\": " << (Enabled ? "true" : "false") << ",\n";
+        os << "  \"elapsed_ms\": "
+           << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count() << ",\n";
+        os << "  \"peak_resident_bytes\": " << peak_resident_bytes() << ",\n";
+        os << "  \"counters\": ";
+        write_counters(totals);
+        os << ",\n";
+
+        os << "  \"threads\": [\n";
+        for (size_t i = 0; i < m_slots.size(); ++i)
+        {
+            os << "    { \"thread\": " << i << ", \"counters\": ";
+            write_counters(m_slots[i]->counters);
+            os << " }" << (i + 1 < m_slots.size() ? ",\n" : "\n");
+        }
+        os << "  ],\n";
+
+        // Trailing empty buckets are left out, bucket b > 0 counts values in [2^(b-1), 2^b).
+        os << "  \"histograms\": {\n";
+        for (size_t h = 0; h < HistogramCount; ++h)
+        {
+            size_t used = BucketCount;
+            while (used > 0 && 0 == histograms[h][used - 1])
+                --used;
+
+            os << "    \"" << HistogramNames[h] << "\": [";
+            for (size_t b = 0; b < used; ++b)
+                os << (b > 0 ? ", " : "") << histograms[h][b];
+            os << ']' << (h + 1 < HistogramCount ? ",\n" : "\n");
+        }
+        os << "  },\n";
+
+        os << "  \"phases\": [\n";
+        for (size_t i = 0; i < m_phases.size(); ++i)
+        {
+            os << "    { \"name\": \"" << m_phases[i].name << "\", \"calls\": " << m_phases[i].calls
+               << ", \"ms\": " << std::chrono::duration<double, std::milli>(m_phases[i].elapsed).count() << " }"
+               << (i + 1 < m_phases.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n";
+        os << "}\n";
+    }
+
+    /// @brief Write the recorded events in the Chrome trace event format, one row per thread slot.
+    /// Call once the threads that record events have finished.
+    void write_trace(std::ostream &os)
+    {
+        std::lock_guard lock(m_mutex);
+
+        const auto microseconds = [&](std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration<double, std::micro>(time - m_start).count();
+        };
+
+        os << "{ \"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        bool first = true;
+        for (const auto &slot : m_slots)
+        {
+            os << (first ? "" : ",\n") << "  { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << slot->index
+               << ", \"args\": { \"name\": \"thread " << slot->index << "\" } }";
+            first = false;
+
+            for (const auto &event : slot->events)
+            {
+                os << ",\n  { \"name\": \"" << event.name << "\", \"cat\": \"" << event.category
+                   << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << slot->index
+                   << ", \"ts\": " << microseconds(event.begin)
+                   << ", \"dur\": " << microseconds(event.end) - microseconds(event.begin) << " }";
+            }
+        }
+        os << "\n] }\n";
+    }
+};
+
+[[nodiscard]] inline Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+/// @brief Holds the slot of the calling thread and hands it back when the thread exits.
+class SlotLease
+{
+
+private:
+
+    ThreadSlot *m_slot;
+
+public:
+
+    SlotLease()
+    : m_slot(registry().acquire())
+    {
+
+    }
+
+    SlotLease(const SlotLease&) = delete;
+    SlotLease& operator=(const SlotLease&) = delete;
+
+    ~SlotLease()
+    {
+        registry().release(m_slot);
+    }
+
+    [[nodiscard]] ThreadSlot& slot() const
+    {
+        return *m_slot;
+    }
+};
+
+[[nodiscard]] inline ThreadSlot& local_slot()
+{
+    thread_local SlotLease lease;
+    return lease.slot();
+}
+
+/// @brief Only the owning thread writes a slot, so a plain load and store avoids a locked add.
+inline void add(std::atomic<uint64_t> &value, uint64_t amount)
+{
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+constexpr void count(Counter counter, uint64_t amount = 1)
+{
+    if constexpr (Enabled)
+    {
+        if !consteval
+        {
+            add(local_slot().counters[static_cast<size_t>(counter)], amount);
+        }
+    }
+}
+
+constexpr void record(Histogram histogram, uint64_t value)
+{
+    if constexpr (Enabled)
+    {
+        if !consteval
+        {
+            add(local_slot().histograms[static_cast<size_t>(histogram)][std::bit_width(value)], 1);
+        }
+    }
+}
+
+/// @brief Record the trace events of the following spans and phases.
+inline void enable_trace(bool enabled = true)
+{
+    if constexpr (Enabled)
+        registry().set_trace(enabled);
+}
+
+/// @brief Event of the trace timeline covering the lifetime of the object.
+/// @param name String literal, only the pointer is kept.
+class Span
+{
+
+private:
+
+    const char *m_name = nullptr;
+
+    const char *m_category = nullptr;
+
+    std::chrono::steady_clock::time_point m_begin;
+
+public:
+
+    explicit Span(const char *name, const char *category = "span")
+    {
+        if constexpr (Enabled)
+        {
+            m_name = name;
+            m_category = category;
+            m_begin = std::chrono::steady_clock::now();
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    ~Span()
+    {
+        if constexpr (Enabled)
+        {
+            if (registry().trace())
+                local_slot().events.push_back({ m_name, m_category, m_begin, std::chrono::steady_clock::now() });
+        }
+    }
+};
+
+/// @brief Span of a phase of a run whose time also adds up in the report under its name, with or
+/// without GOLC_INSTRUMENTATION.
+class Phase
+{
+
+private:
+
+    const char *m_name;
+
+    std::chrono::steady_clock::time_point m_begin;
+
+public:
+
+    explicit Phase(const char *name)
+    : m_name(name)
+    , m_begin(std::chrono::steady_clock::now())
+    {
+
+    }
+
+    Phase(const Phase&) = delete;
+    Phase& operator=(const Phase&) = delete;
+
+    ~Phase()
+    {
+        const auto end = std::chrono::steady_clock::now();
+        registry().add_phase(m_name, end - m_begin);
+        if constexpr (Enabled)
+        {
+            if (registry().trace())
+                local_slot().events.push_back({ m_name, "phase", m_begin, end });
+        }
+    }
+};
+
+inline void write_report(std::ostream &os)
+{
+    registry().write_report(os);
+}
+
+inline void write_trace(std::ostream &os)
+{
+    registry().write_trace(os);
+}
+
+}
@@ -3,12 +3,29 @@
 #include <iostream>
 #include <unordered_set>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <filesystem>
+#include <string_view>
+#include <async_writer.hpp>
 #include <frame.hpp>
+#include <instrumentation.hpp>
 #include <cycle.hpp>
+#include <cycle_catalogue.hpp>
+#include <cycle_database.hpp>
+#include <cycle_memo.hpp>
+#include <enumeration.hpp>
+#include <successor_table.hpp>
+#include <transition_matrix.hpp>
 #include <game_of_life.hpp>
+#include <markov_analysis.hpp>
+#include <orbit_search.hpp>
+#include <perturbation_store.hpp>
+#include <sampling.hpp>
+#include <shard.hpp>
 #include <Eigen/Dense>
 #include <random>
-#include <stack>
 
 using namespace std;
 using namespace chrono;
@@ -28,45 +45,31 @@ random_device rd;
 mt19937 gen(rd());
 uniform_int_distribution<> dis(1000, 9999);
 
+/// @brief Find every cycle reachable from the 2x2 square by repeated single cell perturbations.
+/// @param checkpoint_path File the visited cycles and the frontier are saved to after every level, empty disables checkpoints.
+/// @param resume Continue from checkpoint_path when it exists.
+/// @param perturbations Receives the perturbation outcomes simulated by the search when given,
+/// ids index the found cycles in sorted order.
 template<size_t N>
-std::unordered_set<Cycle<N>, typename Cycle<N>::Hash, typename Cycle<N>::Equal> search_square_orbit()
+CycleSet<N> search_square_orbit(
+    const std::filesystem::path &checkpoint_path = {},
+    bool resume = false,
+    PerturbationStore<N> *perturbations = nullptr)
 {
-    std::unordered_set<Cycle<N>, typename Cycle<N>::Hash, typename Cycle<N>::Equal> cache;
     Frame<N> square_frame((0b11ull << N) | 0b11ull);
     Cycle<N> square_cycle(std::vector<Frame<N>>{ square_frame });
 
-    std::unordered_map<Frame<N>, size_t, typename Frame<N>::Hash> visited_frames;
-    std::vector<Frame<N>> cycle_frames;
-    GameOfLife<N> game;
-
-    std::stack<Cycle<N>> cycleStack;
-    cycleStack.push(square_cycle);
-
-    cache.reserve(1000); // Adjust size accordingly
-
-    while (!cycleStack.empty()) {
-        auto currentCycle = cycleStack.top();
-        cycleStack.pop();
-
-        for (const auto& org_frame : currentCycle.frames()) {
-            for (size_t i = 0; i < Frame<N>::CellCount; ++i) {
-                Frame<N> frame = org_frame; // Local copy within loop scope
-                frame.toggle(i);
-                game.set(frame);
-                auto cycle = game.find_cycle(visited_frames, cycle_frames);
-
-                auto [iter, inserted] = cache.insert(cycle); // Insert and check insertion
-
-                if (!inserted)
-                    continue;
-
-                cycleStack.push(cycle);
-            }
-        }
-    }
-
-    cache.insert(square_cycle);
-    return cache;
+    OrbitSearchOptions options;
+    options.checkpoint_path = checkpoint_path;
+    options.resume = resume;
+    options.report_progress = true;
+    options.record_perturbations = nullptr != perturbations;
+    ParallelOrbitSearch<N> search(options);
+
+    auto cycles = search.explore({ square_cycle });
+    if (perturbations)
+        *perturbations = search.perturbations();
+    return cycles;
 }
 
 int generate_random_id()
@@ -74,302 +77,496 @@ int generate_random_id()
     return dis(gen);
 }
 
+/// @brief Store cycles in a catalogue where the empty board gets id 0 and the rest follow in sorted order.
 template <size_t N>
-unordered_map<Cycle<N>, size_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal> assign_indices(
-    unordered_set<Cycle<N>, typename Cycle<N>::Hash, typename Cycle<N>::Equal> const& cycles)
+CycleCatalogue<N> build_catalogue(
+    CycleSet<N> const& cycles)
 {
-    auto null_cycle = find_if(cycles.begin(), cycles.end(), [](Cycle<N> const &cycle) {
-        Frame<N> zero(0);
-        auto const& frames = cycle.frames();
-        return frames.contains(zero);
-    });
-
-    unordered_map<Cycle<N>, size_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal> indices;
+    vector<Cycle<N>> sorted_cycles(cycles.begin(), cycles.end());
+    sort(sorted_cycles.begin(), sorted_cycles.end(), typename Cycle<N>::Less());
 
-    indices[*null_cycle] = 0;
+    CycleCatalogue<N> catalogue(cycles.size());
 
-    size_t cycle_index_assignment_index = 1;
-    for (const auto &cycle: cycles) {
-        if (typename Cycle<N>::Equal()(cycle, *null_cycle))
-            continue;
+    const Cycle<N> null_cycle;
+    catalogue.insert(null_cycle);
 
-        indices[cycle] = cycle_index_assignment_index++;
-    }
+    for (const auto &cycle: sorted_cycles)
+        catalogue.insert(cycle);
 
-    return indices;
+    return catalogue;
 }
 
-template <size_t N>
-void write_cycle_data(
-    unordered_set<Cycle<N>, typename Cycle<N>::Hash, typename Cycle<N>::Equal> const& cycles,
-    unordered_map<Cycle<N>, size_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal> const& indices)
-{
-    auto file_name = std::format("{}x{}-configurations-{}.txt", N, N, generate_random_id());
-    ofstream os(file_name);
+/// @brief Half-open range of ids handed to a writer as one item.
+using IdRange = std::pair<uint32_t, uint32_t>;
 
-    if (!os.is_open())
+using IdWriter = AsyncWriter<IdRange>;
+
+/// @brief Start a writer thread for a text file, prints a message and returns null when the file can not be created.
+std::unique_ptr<IdWriter> open_writer(const std::string &file_name, std::function<void(uint32_t, OutputBuffer&)> append)
+{
+    try
     {
-        cout << "Could not open file: " << file_name << '\n';
-        return;
+        return std::make_unique<IdWriter>(file_name, [append = std::move(append)](const IdRange &range, OutputBuffer &buffer)
+        {
+            for (uint32_t id = range.first; id < range.second; ++id)
+                append(id, buffer);
+        });
+    }
+    catch (const std::exception &e)
+    {
+        cout << e.what() << '\n';
+        return nullptr;
     }
+}
 
-    for (const auto &cycle: cycles)
+/// @brief Queue the ids [0, count) in ranges small enough to keep the writer busy from the first one.
+/// Stops at the first range the writer refuses, close_writer reports why.
+void push_ids(IdWriter &writer, size_t count)
+{
+    constexpr uint32_t RangeSize = 256;
+    try
     {
-        os << "[T = " << cycle.frames().size() << ", id: " << indices.at(cycle) << "]\n";
+        for (uint32_t begin = 0; begin < count; begin += RangeSize)
+            writer.push({ begin, static_cast<uint32_t>(std::min<size_t>(begin + RangeSize, count)) });
+    }
+    catch (const std::exception &)
+    {
+        // The writer keeps its error for close.
+    }
+}
 
-        for (const auto &frame: cycle.frames())
-        {
-            os << frame.get() << ' ';
-        }
+/// @brief Wait until a writer has written everything and print its statistics, or the error that stopped it.
+void close_writer(std::unique_ptr<IdWriter> writer, std::string_view name)
+{
+    if (!writer)
+        return;
 
-        os << '\n' << cycle << '\n';
+    WriterStats stats;
+    try
+    {
+        stats = writer->close();
+    }
+    catch (const std::exception &e)
+    {
+        cout << "Could not write " << name << ": " << e.what() << '\n';
+        return;
     }
+    cout << "Wrote " << name << ": items=" << stats.items << ", bytes=" << stats.bytes << ", flushes=" << stats.flushes
+         << ", max queue depth=" << stats.max_queue_depth << ", producer wait(ms)=" << stats.producer_wait.count()
+         << ", format(ms)=" << stats.format_time.count() << ", write(ms)=" << stats.write_time.count() << '\n';
+}
 
-    os.close();
+/// @brief Write the catalogue as a binary cycle database and start exporting it to the text format.
+/// @return Writer of the text export, the catalogue has to outlive it.
+template <size_t N>
+std::unique_ptr<IdWriter> write_cycle_data(CycleCatalogue<N> const& catalogue)
+{
+    write_cycle_database(std::format("{}x{}-cycles.db", N, N), catalogue);
+
+    auto writer = open_writer(
+        std::format("{}x{}-configurations-{}.txt", N, N, generate_random_id()),
+        [&catalogue](uint32_t id, OutputBuffer &buffer) { append_cycle_text<N>(buffer, id, catalogue.frames(id)); });
+    if (writer)
+        push_ids(*writer, catalogue.size());
+    return writer;
 }
 
+/// @brief Write the perturbation transition matrix in binary CSR form and start writing the run-length
+/// text format. Rows are numbered by cycle id.
+/// @return Writer of the text format, the matrix has to outlive it.
 template <size_t N>
-void write_matrix_data(
-    unordered_set<Cycle<N>, typename Cycle<N>::Hash, typename Cycle<N>::Equal> const& cycles,
-    unordered_map<Cycle<N>, size_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal> const& indices
-)
+std::unique_ptr<IdWriter> write_matrix_data(TransitionMatrix<N> const& matrix)
 {
-    auto file_name = std::format("{}x{}-matrix-{}.txt", N, N, generate_random_id());
-    ofstream os(file_name);
+    matrix.write_binary(std::format("{}x{}-matrix.bin", N, N));
+
+    auto writer = open_writer(
+        std::format("{}x{}-matrix-{}.txt", N, N, generate_random_id()),
+        [&matrix](uint32_t row, OutputBuffer &buffer) { matrix.append_text_row(buffer, row); });
+    if (writer)
+        push_ids(*writer, matrix.rows());
+    return writer;
+}
 
-    GameOfLife<N> game;
-    unordered_map<Frame<N>, size_t, typename Frame<N>::Hash> visited_frames;
-    unordered_map<Cycle<N>, size_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal> dest_cycles;
-    vector<Frame<N>> cycle_frames;
+/// @brief Rank the cycles by quasi-stationary mass and write the leading eigenvalues and per cycle decay rates.
+template <size_t N>
+void write_markov_analysis(TransitionMatrix<N> const& matrix)
+{
+    const MarkovAnalysis analysis(matrix.sparse());
+    if (analysis.converged_count() < analysis.eigenvalues().size())
+    {
+        cout << "Only " << analysis.converged_count() << " of " << analysis.eigenvalues().size()
+             << " eigenvalues converged after " << analysis.restarts() << " restarts\n";
+    }
 
-    Cycle<N> const null_cycle;
-    vector<Cycle<N>> cycles_as_vector(cycles.size(), null_cycle);
-    vector<int> destination_frequencies(cycles.size(), 0);
+    const auto file_name = std::format("{}x{}-decay-rates.txt", N, N);
+    ofstream os(file_name);
 
-    for(auto const& cycle : cycles)
+    if (!os.is_open())
     {
-        const auto id = indices.at(cycle);
-        cycles_as_vector[id] = cycle;
+        cout << "Could not open file: " << file_name << '\n';
+        return;
     }
 
-    // This loop iterates by index, which means, we don't need to mark what cycle
-    // each row will correspond to as the row number - 1 and the index are the same
-    for (auto const& cycle: cycles_as_vector) {
-        for (auto const& org_frame: cycle.frames()) {
-            for (size_t i = 0; i < Frame<N>::CellCount; ++i) {
-                Frame<N> frame = org_frame;
-                frame.toggle(i);
-                game.set(frame);
-                auto dest_cycle = game.find_cycle(visited_frames, cycle_frames);
-
-                if (dest_cycles.contains(dest_cycle))
-                    dest_cycles[dest_cycle]++;
-                else
-                    dest_cycles[dest_cycle] = 1;
-            }
-        }
-
-        size_t freq = 0;
+    analysis.write(os);
 
-        const Index row = indices.at(cycle);
+    os.close();
+}
 
-        // i'th element is the frequency at which current cycle ends up in cycle with index i.
-        auto const n = static_cast<int64_t>(cycle.frames().size() * Frame<N>::CellCount);
+/// @brief This write is only relevant for 5x5 torus. Together with cycle animations there
+/// should be displayed frames where each cell shows the id of a cycle that will be reached
+/// if said cell was to be perturbed for the respective frame configuration of the cycle.
+/// @param catalogue
+/// @param perturbations Perturbation outcomes of the catalogue cycles.
+void write_5x5(CycleCatalogue<5> const& catalogue, PerturbationStore<5> const& perturbations)
+{
+    auto writer = open_writer("5x5-destination-frames.txt", [&](uint32_t id, OutputBuffer &buffer)
+    {
+        const auto frames = catalogue.frames(id);
 
-        // subtract n from diagonal
-        destination_frequencies[row] -= n;
+        buffer.append("[T = ");
+        buffer.append(frames.size());
+        buffer.append(", id: ");
+        buffer.append(id);
+        buffer.append("]\n");
 
-        // Here we iterate in a shuffled manner, but we want that element i in this row
-        // would correspond to frequency where destination is cycle with index i
-        for (const auto &[dest_cycle, dest_freq]: dest_cycles) {
-            const Index col = indices.at(dest_cycle);
-            destination_frequencies[col] += dest_freq;
+        for (const auto &frame: frames)
+        {
+            buffer.append(frame.get());
+            buffer.append(' ');
         }
 
-        size_t zero_counter = 0;
+        buffer.append('\n');
 
-        for(auto const& frequency : destination_frequencies)
+        // Destination ids laid out like the frames, one block of 5x5 ids per frame.
+        for (size_t row = 0; row < 5; ++row)
         {
-            auto const scaled = static_cast<int64_t>(frequency * N * N);
-
-            if(0 == scaled)
-            {
-                ++zero_counter;
-            }
-            else
+            for (size_t frame_index = 0; frame_index < frames.size(); ++frame_index)
             {
-                // reset the zero counter and print zeros
-
-                if(zero_counter > 0)
-                {
-                    if(1 == zero_counter)
-                    {
-                        os << 0 << ' ';
-                    }
-                    else
-                    {
-                        os << 0 << '$' << zero_counter << ' ';
-                    }
-
-                    zero_counter = 0;
-                }
-
-                if(0 == scaled % n)
-                {
-                    os << scaled / n << ' ';
-                }
-                else
+                for (size_t col = 0; col < 5; ++col)
                 {
-                    int d = gcd(scaled, n);
-                    char buf[20];
-                    sprintf(buf, "%lli/%lli", scaled / d, n / d);
-                    os << buf << ' ';
+                    buffer.append(perturbations.destination(id, frame_index, row * 5 + col));
+                    buffer.append(' ');
                 }
+                buffer.append("  ");
             }
+            buffer.append('\n');
         }
 
-        if(zero_counter > 0)
-        {
-            if(1 == zero_counter)
-            {
-                os << 0 << ' ';
-            }
-            else
-            {
-                os << 0 << '$' << zero_counter << ' ';
-            }
-
-            zero_counter = 0;
-        }
-        os << '\n';
-
-        destination_frequencies.clear();
-        dest_cycles.clear();
-    }
+        buffer.append('\n');
+        append_cycle_drawing<5>(buffer, frames);
+        buffer.append('\n');
+    });
+    if (!writer)
+        return;
 
-    os.close();
+    push_ids(*writer, catalogue.size());
+    close_writer(std::move(writer), "5x5-destination-frames.txt");
 }
 
-/// @brief This write is only relevant for 5x5 torus. Together with cycle animations there
-/// should be displayed frames where each cell shows the id of a cycle that will be reached
-/// if said cell was to be perturbed for the respective frame configuration of the cycle.
-/// @param cycles
-/// @param indices
-void write_5x5(
-    unordered_set<Cycle<5>, typename Cycle<5>::Hash, typename Cycle<5>::Equal> const& cycles,
-    unordered_map<Cycle<5>, size_t, typename Cycle<5>::Hash, typename Cycle<5>::Equal> const& indices)
+/// @brief Write the period, basin size and longest transient of every cycle of the successor table. The table
+/// sorts its cycles and the empty board comes first, so the indices are the ids build_catalogue assigns.
+template <size_t N>
+void write_basin_sizes(SuccessorTable<N> const& table)
 {
-
-    const string filename = "5x5-destination-frames.txt";
-    ofstream os(filename);
-
-    unordered_map<Frame<5>, size_t, typename Frame<5>::Hash> visited_frames;
-    vector<Frame<5>> cycle_frames;
-
-    GameOfLife<5> game;
+    const auto file_name = std::format("{}x{}-basins.txt", N, N);
+    ofstream os(file_name);
 
     if (!os.is_open())
     {
-        cout << "Could not open file: " << filename << '\n';
+        cout << "Could not open file: " << file_name << '\n';
         return;
     }
 
-    for (const auto &cycle: cycles)
+    vector<uint16_t> longest_transients(table.cycles().size(), 0);
+    for (uint64_t state = 0; state < SuccessorTable<N>::StateCount; ++state)
     {
-        os << "[T = " << cycle.frames().size() << ", id: " << indices.at(cycle) << "]\n";
+        auto &longest = longest_transients[table.attractor(static_cast<uint32_t>(state))];
+        longest = std::max(longest, table.transient(static_cast<uint32_t>(state)));
+    }
 
-        for (const auto &frame: cycle.frames())
-        {
-            os << frame.get() << ' ';
-        }
+    os << "# id period basin longest_transient\n";
+    for (size_t i = 0; i < table.cycles().size(); ++i)
+        os << i << ' ' << table.cycles()[i].frames().size() << ' ' << table.basin_sizes()[i] << ' ' << longest_transients[i] << '\n';
 
-        os << '\n';
+    os.close();
+}
 
-        // perturbed destination indices
-        size_t pdi[cycle.frames().size()][5][5];
+void main_flow(bool resume)
+{
+    constexpr size_t N = 5;
+    auto start = std::chrono::steady_clock::now();
+    PerturbationStore<N> discovered;
+    const auto cycles = [&]
+    {
+        const instrumentation::Phase phase("discovery");
+        return search_square_orbit<N>(std::format("{}x{}-orbit.checkpoint", N, N), resume, &discovered);
+    }();
+    cout << "Elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size() << '\n';
+    const auto catalogue = [&]
+    {
+        const instrumentation::Phase phase("canonicalization");
+        return build_catalogue(cycles);
+    }();
+    const auto memory = catalogue.memory_usage();
+    cout << "Catalogue bytes per cycle: " << memory.bytes_per_cycle
+         << ", peak resident bytes: " << memory.peak_resident_bytes << '\n';
+    // The text export runs on its own thread while the outcomes are moved over and the matrix is built.
+    auto cycle_writer = [&]
+    {
+        const instrumentation::Phase phase("output");
+        return write_cycle_data(catalogue);
+    }();
 
-        // Find indices of perturbed cycle frames
-        size_t frame_index = 0;
-        for (const auto &frame: cycle.frames())
-        {
-            for (size_t i = 0; i < Frame<5>::CellCount; ++i) {
-                Frame<5> perturbed_frame = frame;
-                perturbed_frame.toggle(i);
-                game.set(perturbed_frame);
-                auto dest_cycle = game.find_cycle(visited_frames, cycle_frames);
+    const auto matrix = [&]
+    {
+        const instrumentation::Phase phase("matrix");
 
-                //cout << dest_cycle << '\n';
+        // The search already simulated every perturbation, only move its outcomes over to the catalogue ids.
+        vector<Cycle<N>> sorted_cycles(cycles.begin(), cycles.end());
+        sort(sorted_cycles.begin(), sorted_cycles.end(), typename Cycle<N>::Less());
+        const auto perturbations = discovered.remapped(catalogue, sorted_cycles);
+        perturbations.save(std::format("{}x{}-perturbations.bin", N, N));
 
-                const size_t perturbed_cycle_index = indices.at(dest_cycle);
-                //cout << "cycle id: " << perturbed_cycle_index << '\n';
-                const size_t row = i / 5, col = i % 5;
+        return TransitionMatrix<N>(perturbations);
+    }();
+    auto matrix_writer = [&]
+    {
+        const instrumentation::Phase phase("output");
+        return write_matrix_data(matrix);
+    }();
 
-                //cout << "(row, col) = (" << row << ", " << col << ")\n";
+    {
+        const instrumentation::Phase phase("analysis");
+        write_markov_analysis(matrix);
+    }
 
-                pdi[frame_index][col][row] = perturbed_cycle_index;
-            }
-            ++frame_index;
-        }
+    const instrumentation::Phase phase("output");
+    close_writer(std::move(cycle_writer), "configurations");
+    close_writer(std::move(matrix_writer), "matrix");
+}
+
+/// @brief Start states [0, StartStates5x5) that the 5x5 enumerations cover. Translating a dead cell
+/// of a board to the last cell gives a state below 2^24, so every orbit but the one of the full
+/// board has its representative in range, and the full board dies out into the empty one.
+constexpr absl::uint128 StartStates5x5 = absl::uint128(1) << 24;
+
+/// @brief Find every cycle of the 5x5 torus from its successor table, or by simulating the orbit
+/// representatives of every start state when enumerate is set, and write the destination frames.
+void special_5x5_flow(bool resume, bool enumerate)
+{
+    auto start = std::chrono::steady_clock::now();
 
-        // print pretty pdi
-        for(size_t row = 0; row < 5; ++row)
+    const auto cycles = [&]
+    {
+        const instrumentation::Phase phase("discovery");
+        CycleSet<5> found;
+        if (enumerate)
         {
-            for(size_t frame = 0; frame < cycle.frames().size(); ++frame)
-            {
-                for(size_t col = 0; col < 5; ++col)
-                {
-                    os << pdi[frame][col][row] << ' ';
-                }
-                os << "  ";
-            }
-            os << '\n';
+            EnumerationOptions options;
+            options.report_progress = true;
+            // Every state in range has its smaller representative in range too.
+            options.symmetry_reduced = true;
+            options.checkpoint_path = "5x5-enumeration.checkpoint";
+            options.resume = resume;
+            ParallelEnumerator<5> enumerator(options);
+            found = enumerator.enumerate(0, StartStates5x5);
+            cout << "Threads: " << enumerator.thread_count() << '\n';
+        }
+        else
+        {
+            // One pass over the functional graph gives the cycles and how many states end up in each.
+            const SuccessorTable<5> table;
+            found.insert(table.cycles().begin(), table.cycles().end());
+            write_basin_sizes(table);
         }
+        return found;
+    }();
+
+    cout << "Elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size() << '\n';
+    const auto catalogue = [&]
+    {
+        const instrumentation::Phase phase("canonicalization");
+        return build_catalogue(cycles);
+    }();
 
-        os << '\n' << cycle << '\n';
+    // Outcomes saved by an earlier run over the same catalogue are reused.
+    const std::filesystem::path perturbations_path = "5x5-perturbations.bin";
+    PerturbationStore<5> perturbations;
+    {
+        const instrumentation::Phase phase("matrix");
+        if (resume && std::filesystem::exists(perturbations_path))
+            perturbations = PerturbationStore<5>::load(perturbations_path);
+        if (!perturbations.matches(catalogue))
+        {
+            perturbations = PerturbationStore<5>::compute(catalogue);
+            perturbations.save(perturbations_path);
+        }
     }
 
-    os.close();
+    const instrumentation::Phase phase("output");
+    write_5x5(catalogue, perturbations);
 }
 
-void main_flow()
+/// @brief Enumerate the chunks of the start states [0, state_count) that belong to a shard and write the
+/// cycles they reach as a cycle database, GoLCMergeShards combines the databases of all shards.
+template<size_t N>
+void shard_flow(const Shard &shard, absl::uint128 state_count, bool resume)
 {
-    constexpr size_t N = 5;
     auto start = std::chrono::steady_clock::now();
-    auto cycles = search_square_orbit<N>();
-    cout << "Elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size() << '\n';
-    const auto indices = assign_indices(cycles);
-    write_cycle_data(cycles, indices);
-    write_matrix_data(cycles, indices);
+    const auto name = std::format("{}x{}-shard-{}-of-{}", N, N, shard.index, shard.count);
+
+    EnumerationOptions options;
+    options.report_progress = true;
+    // Only orbit representatives are simulated, each one lies in exactly one shard.
+    options.symmetry_reduced = true;
+    options.shard_index = shard.index;
+    options.shard_count = shard.count;
+    options.checkpoint_path = name + ".checkpoint";
+    options.resume = resume;
+    ParallelEnumerator<N> enumerator(options);
+
+    const auto cycles = [&]
+    {
+        const instrumentation::Phase phase("discovery");
+        return enumerator.enumerate(0, state_count);
+    }();
+
+    cout << "Shard " << shard.index << '/' << shard.count << ", elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size() << '\n';
+
+    const instrumentation::Phase phase("output");
+    vector<Cycle<N>> sorted_cycles(cycles.begin(), cycles.end());
+    sort(sorted_cycles.begin(), sorted_cycles.end(), typename Cycle<N>::Less());
+    CycleCatalogue<N> catalogue(sorted_cycles.size());
+    for (const auto &cycle : sorted_cycles)
+        catalogue.insert(cycle);
+
+    write_cycle_database(name + ".db", catalogue);
 }
 
-void special_5x5_flow()
+/// @brief Sample the 11x11 torus until new cycles become rare and store them in a cycle database.
+void sampling_11x11_flow()
 {
     auto start = std::chrono::steady_clock::now();
-    unordered_set<Cycle<5>, typename Cycle<5>::Hash, typename Cycle<5>::Equal> cycles;
-    unordered_map<Frame<5>, size_t, typename Frame<5>::Hash> visited_frames;
-    vector<Frame<5>> cycle_frames;
-    GameOfLife<5> game;
-    for(size_t i = 0; i < (1 << 24); ++i)
+
+    SamplingOptions options;
+    options.mode = SamplingMode::Blocks;
+    options.max_samples = uint64_t(1) << 32;
+    options.min_new_cycles_per_million = 1;
+    options.report_progress = true;
+    ParallelSampler<11> sampler(options);
+
+    const auto cycles = [&]
     {
-        game.set(Frame<5>(i));
-        const auto cycle = game.find_cycle(visited_frames, cycle_frames);
-        cycles.insert(cycle);
-
-        constexpr double step = 1.f / 20.f;
-        constexpr size_t items_per_step = (1 << 24) * step;
-        if(i % items_per_step == 0) {
-            cout << "Searched " << 100 * static_cast<double>(i) / static_cast<double>(1 << 24) << "% of all states\n";
-        }
+        const instrumentation::Phase phase("discovery");
+        return sampler.sample();
+    }();
 
+    cout << "Elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size()
+         << ", samples: " << sampler.samples_taken() << '\n';
+    write_cycle_database("11x11-cycles.db", build_catalogue(cycles));
+}
+
+/// @brief Write the instrumentation report and trace of the run when their paths are given.
+void write_run_report(const std::filesystem::path &report_path, const std::filesystem::path &trace_path)
+{
+    if (!instrumentation::Enabled && !(report_path.empty() && trace_path.empty()))
+        cout << "Built without GOLC_INSTRUMENTATION, the report has no counters or histograms and no trace is written\n";
+
+    if (!report_path.empty())
+    {
+        ofstream os(report_path);
+        if (!os.is_open())
+            cout << "Could not open file: " << report_path.string() << '\n';
+        else
+            instrumentation::write_report(os);
     }
 
-    cout << "Elapsed(ms)=" << since(start).count() << ", cycles found: " << cycles.size() << '\n';
-    const auto indices = assign_indices(cycles);
-    write_5x5(cycles, indices);
+    if (!trace_path.empty() && instrumentation::Enabled)
+    {
+        ofstream os(trace_path);
+        if (!os.is_open())
+            cout << "Could not open file: " << trace_path.string() << '\n';
+        else
+            instrumentation::write_trace(os);
+    }
 }
 
+/// @brief Print the command line options.
+void print_usage(std::string_view program)
+{
+    cout << "Usage: " << program << " [options]\n"
+         << "  --flow 5x5       catalogue every 5x5 cycle with its destination frames (default)\n"
+         << "  --flow orbit     search the perturbation orbit of the 2x2 square and analyse its transition matrix\n"
+         << "  --flow sampling  sample 11x11 start states until new cycles become rare and store them in a database\n"
+         << "  --enumerate      simulate the 5x5 start states instead of building their successor table\n"
+         << "  --shard i/k      only enumerate slice i of k of the 5x5 start states and write it as a cycle database\n"
+         << "  --resume         continue from the checkpoint an interrupted run left behind\n"
+         << "  --report path    write the instrumentation counters and phase timings as JSON\n"
+         << "  --trace path     write a Chrome trace event timeline of the phases and workers\n"
+         << "  --help           print this message\n";
+}
 
 int main(int argc, char** argv) {
-    special_5x5_flow();
+    bool resume = false;
+    bool enumerate = false;
+    std::string_view flow = "5x5";
+    std::optional<Shard> shard;
+    std::filesystem::path report_path, trace_path;
+
+    // A run launched from a job script must not quietly fall back to the default flow.
+    const auto reject = [&](std::string_view message, std::string_view value)
+    {
+        cout << message << value << '\n';
+        print_usage(argv[0]);
+        return 1;
+    };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg(argv[i]);
+        if ("--help" == arg)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if ("--resume" == arg)
+            resume = true;
+        else if ("--enumerate" == arg)
+            enumerate = true;
+        else if ("--flow" == arg || "--report" == arg || "--trace" == arg || "--shard" == arg)
+        {
+            if (i + 1 == argc || std::string_view(argv[i + 1]).starts_with("--"))
+                return reject("Missing value for ", arg);
+
+            const std::string_view value(argv[++i]);
+            if ("--flow" == arg)
+                flow = value;
+            else if ("--report" == arg)
+                report_path = value;
+            else if ("--trace" == arg)
+                trace_path = value;
+            else
+            {
+                shard = Shard::parse(value);
+                if (!shard)
+                    return reject("Expected --shard i/k with i < k, got: ", value);
+            }
+        }
+        else
+            return reject("Unknown argument: ", arg);
+    }
+    if ("5x5" != flow && "orbit" != flow && "sampling" != flow)
+        return reject("Expected --flow 5x5, orbit or sampling, got: ", flow);
+    instrumentation::enable_trace(!trace_path.empty());
+
+    if (shard)
+        shard_flow<5>(*shard, StartStates5x5, resume);
+    else if ("orbit" == flow)
+        main_flow(resume);
+    else if ("sampling" == flow)
+        sampling_11x11_flow();
+    else
+        special_5x5_flow(resume, enumerate);
+    write_run_report(report_path, trace_path);
     return 0;
 }
\ No newline at end of file
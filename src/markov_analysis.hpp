@@ -0,0 +1,391 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/Eigenvalues>
+#include <Eigen/Sparse>
+#include <work_stealing.hpp>
+
+struct MarkovOptions
+{
+    /// @brief Number of threads used for matrix-vector products, zero picks the hardware concurrency.
+    size_t thread_count = 0;
+
+    /// @brief Power iteration stops once the L1 change of the distribution drops below this.
+    double tolerance = 1e-12;
+
+    size_t max_iterations = 1000000;
+
+    /// @brief Give cycles that are never left no mass. With an absorbing cycle such as the empty
+    /// board the plain stationary distribution sits entirely on it, conditioning on not being
+    /// absorbed gives the quasi-stationary distribution of the remaining cycles instead.
+    bool quasi_stationary = true;
+
+    /// @brief Number of leading eigenvalues to compute.
+    size_t eigenvalue_count = 8;
+
+    /// @brief Dimension of the Krylov subspace, zero picks max(4 * eigenvalue_count, 64).
+    size_t krylov_dimension = 0;
+
+    /// @brief An eigenvalue mu of P has converged once the residual norm of its Ritz vector drops
+    /// below this times max(|mu|, eps^(2/3)).
+    double eigenvalue_tolerance = 1e-10;
+
+    /// @brief Number of thick restarts before the eigenvalues that have not converged are given up on.
+    size_t max_restarts = 1000;
+};
+
+/// @brief Spectral analysis of the continuous time Markov chain given by a perturbation rate matrix.
+/// The chain is uniformized into P = I + Q / lambda with lambda above the largest escape rate, so
+/// P^T is stored once in compressed rows and every matrix-vector product is a parallel gather.
+/// The stationary distribution comes from power iteration on P and the eigenvalues of Q closest
+/// to zero from a Krylov-Schur iteration on P, nothing of size cycles^2 is ever stored.
+class MarkovAnalysis
+{
+
+public:
+
+    using RateMatrix = Eigen::SparseMatrix<double, Eigen::RowMajor>;
+
+private:
+
+    constexpr static Eigen::Index RowsPerTask = 1 << 12;
+
+    MarkovOptions m_options;
+
+    WorkStealingScheduler m_scheduler;
+
+    /// @brief Transposed uniformized transition matrix.
+    RateMatrix m_transition_transposed;
+
+    double m_uniformization_rate;
+
+    std::vector<double> m_escape_rates;
+
+    Eigen::VectorXd m_stationary;
+
+    size_t m_iterations = 0;
+
+    double m_residual = 0;
+
+    std::vector<std::complex<double>> m_eigenvalues;
+
+    /// @brief Residual norm of the Ritz vector of every eigenvalue, in units of Q.
+    std::vector<double> m_eigenvalue_residuals;
+
+    std::vector<uint8_t> m_converged;
+
+    size_t m_restarts = 0;
+
+    [[nodiscard]] size_t task_count() const
+    {
+        return static_cast<size_t>((m_transition_transposed.rows() + RowsPerTask - 1) / RowsPerTask);
+    }
+
+    /// @brief y = P^T x
+    void multiply(const Eigen::VectorXd &x, Eigen::VectorXd &y)
+    {
+        m_scheduler.run(task_count(), [&](size_t, size_t task_index)
+        {
+            const Eigen::Index begin = static_cast<Eigen::Index>(task_index) * RowsPerTask;
+            const Eigen::Index end = std::min(begin + RowsPerTask, m_transition_transposed.rows());
+            for (Eigen::Index row = begin; row < end; ++row)
+            {
+                double sum = 0;
+                for (RateMatrix::InnerIterator it(m_transition_transposed, row); it; ++it)
+                    sum += it.value() * x[it.col()];
+                y[row] = sum;
+            }
+        });
+    }
+
+    void compute_stationary()
+    {
+        const Eigen::Index n = m_transition_transposed.rows();
+
+        std::vector<Eigen::Index> absorbing;
+        if (m_options.quasi_stationary)
+        {
+            for (Eigen::Index row = 0; row < n; ++row)
+            {
+                if (0 == m_escape_rates[row])
+                    absorbing.push_back(row);
+            }
+            if (absorbing.size() == static_cast<size_t>(n))
+                absorbing.clear();
+        }
+
+        m_stationary = Eigen::VectorXd::Constant(n, 1.0 / static_cast<double>(n - absorbing.size()));
+        for (const auto row : absorbing)
+            m_stationary[row] = 0;
+        Eigen::VectorXd next(n);
+
+        for (m_iterations = 0; m_iterations < m_options.max_iterations; ++m_iterations)
+        {
+            multiply(m_stationary, next);
+            for (const auto row : absorbing)
+                next[row] = 0;
+            next /= next.sum();
+            m_residual = (next - m_stationary).lpNorm<1>();
+            m_stationary.swap(next);
+
+            if (m_residual < m_options.tolerance)
+                break;
+        }
+    }
+
+    /// @brief Extend the Krylov decomposition P^T V_j = V_{j+1} R from j = begin to j = end columns
+    /// with Arnoldi steps. Columns before begin may come from a restart, so R is only Hessenberg
+    /// from column begin on.
+    /// @return Number of columns reached, less than end when the subspace turned out to be invariant.
+    Eigen::Index extend(Eigen::MatrixXd &basis, Eigen::MatrixXd &rayleigh, Eigen::Index begin, Eigen::Index end)
+    {
+        Eigen::VectorXd w(basis.rows());
+        for (Eigen::Index j = begin; j < end; ++j)
+        {
+            multiply(basis.col(j), w);
+
+            // Two passes of Gram-Schmidt keep the basis orthogonal to working precision.
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                const Eigen::VectorXd projection = basis.leftCols(j + 1).transpose() * w;
+                w -= basis.leftCols(j + 1) * projection;
+                rayleigh.col(j).head(j + 1) += projection;
+            }
+
+            rayleigh(j + 1, j) = w.norm();
+            if (rayleigh(j + 1, j) < 1e-12)
+            {
+                rayleigh(j + 1, j) = 0;
+                return j + 1;
+            }
+            basis.col(j + 1) = w / rayleigh(j + 1, j);
+        }
+        return end;
+    }
+
+    /// @brief Krylov-Schur iteration: the decomposition is extended to the full dimension, the Ritz
+    /// pairs of the projected matrix are ordered by real part and the subspace of the leading ones
+    /// is kept as the start of the next extension. A complex pair is kept or dropped as a whole,
+    /// its real and imaginary parts span a real invariant subspace of the projection.
+    void compute_eigenvalues()
+    {
+        const auto n = static_cast<size_t>(m_transition_transposed.rows());
+        const size_t requested = m_options.krylov_dimension > 0
+            ? m_options.krylov_dimension
+            : std::max<size_t>(4 * m_options.eigenvalue_count, 64);
+        const auto m = static_cast<Eigen::Index>(std::min(std::max(requested, m_options.eigenvalue_count + 2), n));
+        const auto wanted = static_cast<Eigen::Index>(std::min<size_t>(m_options.eigenvalue_count, m));
+
+        Eigen::MatrixXd basis(n, m + 1);
+        Eigen::MatrixXd rayleigh = Eigen::MatrixXd::Zero(m + 1, m);
+        basis.col(0) = Eigen::VectorXd::Ones(static_cast<Eigen::Index>(n)).normalized();
+
+        const double eps23 = std::pow(std::numeric_limits<double>::epsilon(), 2.0 / 3.0);
+
+        Eigen::Index kept = 0;
+        std::vector<Eigen::Index> order;
+        Eigen::VectorXcd ritz_values;
+        std::vector<double> residuals;
+        for (m_restarts = 0;; ++m_restarts)
+        {
+            const Eigen::Index dimension = extend(basis, rayleigh, kept, m);
+
+            const Eigen::EigenSolver<Eigen::MatrixXd> solver(rayleigh.topLeftCorner(dimension, dimension));
+            ritz_values = solver.eigenvalues();
+            const Eigen::MatrixXcd ritz_vectors = solver.eigenvectors();
+
+            order.resize(static_cast<size_t>(dimension));
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(), [&](Eigen::Index a, Eigen::Index b)
+            {
+                const auto x = ritz_values[a], y = ritz_values[b];
+                return x.real() != y.real() ? x.real() > y.real() : x.imag() > y.imag();
+            });
+
+            // Without an invariant subspace the unit Ritz vector y leaves a residual of |r^T y| along v_{m+1}.
+            residuals.assign(static_cast<size_t>(dimension), 0.0);
+            if (dimension == m)
+            {
+                const Eigen::RowVectorXcd coupling = rayleigh.row(m).cast<std::complex<double>>();
+                for (Eigen::Index i = 0; i < dimension; ++i)
+                    residuals[i] = std::abs((coupling * ritz_vectors.col(i)).value());
+            }
+
+            const auto converged = [&](Eigen::Index i)
+            {
+                return residuals[i] <= m_options.eigenvalue_tolerance * std::max(std::abs(ritz_values[i]), eps23);
+            };
+            const Eigen::Index reported = std::min(wanted, dimension);
+            bool done = dimension < m || m_restarts >= m_options.max_restarts;
+            if (!done)
+            {
+                done = true;
+                for (Eigen::Index i = 0; i < reported; ++i)
+                    done = done && converged(order[i]);
+            }
+
+            if (done)
+            {
+                m_eigenvalues.clear();
+                m_eigenvalue_residuals.clear();
+                m_converged.clear();
+                for (Eigen::Index i = 0; i < reported; ++i)
+                {
+                    // Eigenvalue mu of P belongs to eigenvalue lambda * (mu - 1) of Q.
+                    m_eigenvalues.push_back(m_uniformization_rate * (ritz_values[order[i]] - 1.0));
+                    m_eigenvalue_residuals.push_back(m_uniformization_rate * residuals[order[i]]);
+                    m_converged.push_back(converged(order[i]));
+                }
+                return;
+            }
+
+            // Keep the wanted Ritz pairs and half of the others to speed up convergence, without
+            // splitting a complex pair or filling the whole subspace.
+            kept = std::min(wanted + (m - wanted) / 2, m - 1);
+            if (kept > 0 && kept < m && ritz_values[order[kept - 1]].imag() > 0)
+                kept += kept + 1 < m ? 1 : -1;
+
+            Eigen::MatrixXd kept_vectors(m, kept);
+            for (Eigen::Index i = 0; i < kept; ++i)
+            {
+                if (ritz_values[order[i]].imag() < 0)
+                    kept_vectors.col(i) = ritz_vectors.col(order[i]).imag();
+                else
+                    kept_vectors.col(i) = ritz_vectors.col(order[i]).real();
+            }
+            const Eigen::HouseholderQR<Eigen::MatrixXd> qr(kept_vectors);
+            const Eigen::MatrixXd q = qr.householderQ() * Eigen::MatrixXd::Identity(m, kept);
+
+            // P^T V Q = V Q (Q^T H Q) + v_{m+1} (r^T Q) is again a Krylov decomposition.
+            const Eigen::MatrixXd projected = q.transpose() * rayleigh.topRows(m) * q;
+            const Eigen::RowVectorXd coupling = rayleigh.row(m) * q;
+
+            basis.leftCols(kept) = basis.leftCols(m) * q;
+            basis.col(kept) = basis.col(m);
+            rayleigh.setZero();
+            rayleigh.topLeftCorner(kept, kept) = projected;
+            rayleigh.row(kept).head(kept) = coupling;
+        }
+    }
+
+public:
+
+    /// @param rates Rate matrix Q with non-negative off-diagonal entries and rows summing to zero.
+    explicit MarkovAnalysis(const RateMatrix &rates, const MarkovOptions &options = {})
+    : m_options(options)
+    , m_scheduler(options.thread_count)
+    , m_escape_rates(static_cast<size_t>(rates.rows()), 0.0)
+    {
+        // Also turns the -0 of cycles that are never left into 0.
+        for (Eigen::Index row = 0; row < rates.rows(); ++row)
+            m_escape_rates[row] = std::max(0.0, -rates.coeff(row, row));
+
+        // Staying above the largest escape rate keeps P aperiodic.
+        const double max_escape_rate = *std::max_element(m_escape_rates.begin(), m_escape_rates.end());
+        m_uniformization_rate = 1.05 * std::max(max_escape_rate, 1.0);
+
+        RateMatrix transition = rates / m_uniformization_rate;
+        for (Eigen::Index row = 0; row < rates.rows(); ++row)
+            transition.coeffRef(row, row) += 1.0;
+        m_transition_transposed = transition.transpose();
+        m_transition_transposed.makeCompressed();
+
+        compute_stationary();
+        compute_eigenvalues();
+    }
+
+    /// @brief Limit of the distribution started from the uniform distribution over all cycles,
+    /// conditioned on not being absorbed when quasi_stationary is set.
+    [[nodiscard]] const Eigen::VectorXd& stationary() const
+    {
+        return m_stationary;
+    }
+
+    [[nodiscard]] size_t iterations() const
+    {
+        return m_iterations;
+    }
+
+    /// @brief L1 change of the distribution in the last power iteration step.
+    [[nodiscard]] double residual() const
+    {
+        return m_residual;
+    }
+
+    /// @brief Leading eigenvalues of Q ordered by descending real part, the first one is zero.
+    [[nodiscard]] const std::vector<std::complex<double>>& eigenvalues() const
+    {
+        return m_eigenvalues;
+    }
+
+    /// @brief Residual norm of the Ritz vector of each of eigenvalues(), in units of Q.
+    [[nodiscard]] const std::vector<double>& eigenvalue_residuals() const
+    {
+        return m_eigenvalue_residuals;
+    }
+
+    /// @brief Whether an eigenvalue met eigenvalue_tolerance, the others are estimates that ran out of restarts.
+    [[nodiscard]] bool converged(size_t eigenvalue) const
+    {
+        return 0 != m_converged[eigenvalue];
+    }
+
+    [[nodiscard]] size_t converged_count() const
+    {
+        return static_cast<size_t>(std::count(m_converged.begin(), m_converged.end(), 1));
+    }
+
+    /// @brief Number of thick restarts the eigenvalues took.
+    [[nodiscard]] size_t restarts() const
+    {
+        return m_restarts;
+    }
+
+    /// @brief Rate at which a cycle is left after a perturbation, the negated diagonal of Q.
+    [[nodiscard]] double decay_rate(size_t cycle) const
+    {
+        return m_escape_rates[cycle];
+    }
+
+    /// @return Cycle indices ordered by descending stationary mass, ties by index.
+    [[nodiscard]] std::vector<uint32_t> ranking() const
+    {
+        std::vector<uint32_t> order(static_cast<size_t>(m_stationary.size()));
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+        {
+            return m_stationary[a] > m_stationary[b];
+        });
+        return order;
+    }
+
+    /// @brief Write the eigenvalues with their residual and whether they converged, then a line per
+    /// cycle in ranking order with its stationary mass, decay rate and mean lifetime.
+    void write(std::ostream &os) const
+    {
+        os << "# eigenvalues: real imag residual converged, " << converged_count() << " of " << m_eigenvalues.size()
+           << " converged after " << m_restarts << " restarts\n";
+        for (size_t i = 0; i < m_eigenvalues.size(); ++i)
+        {
+            os << m_eigenvalues[i].real() << ' ' << m_eigenvalues[i].imag() << ' ' << m_eigenvalue_residuals[i] << ' '
+               << (converged(i) ? 1 : 0) << '\n';
+        }
+
+        os << "# rank id stationary decay_rate lifetime\n";
+        const auto order = ranking();
+        for (size_t rank = 0; rank < order.size(); ++rank)
+        {
+            const double rate = m_escape_rates[order[rank]];
+            os << rank << ' ' << order[rank] << ' ' << m_stationary[order[rank]] << ' ' << rate << ' '
+               << (rate > 0 ? 1.0 / rate : INFINITY) << '\n';
+        }
+    }
+};
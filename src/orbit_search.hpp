@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+#include <checkpoint.hpp>
+#include <concurrent_cycle_set.hpp>
+#include <cycle.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <perturbation_store.hpp>
+#include <work_stealing.hpp>
+
+struct OrbitSearchOptions
+{
+    /// @brief Number of worker threads, zero picks the hardware concurrency.
+    size_t thread_count = 0;
+
+    /// @brief File the visited cycles and the frontier are written to after every level, empty disables checkpoints.
+    std::filesystem::path checkpoint_path;
+
+    /// @brief Continue from checkpoint_path when it exists instead of starting over.
+    bool resume = false;
+
+    /// @brief Print the frontier size and timing of every level.
+    bool report_progress = false;
+
+    /// @brief Keep the destination of every perturbation simulated during the search. Levels
+    /// expanded before a resumed checkpoint are not recorded, their rows stay incomplete.
+    bool record_perturbations = false;
+};
+
+/// @brief Size and timing of one level of the orbit search.
+struct OrbitLevel
+{
+    /// @brief Number of cycles expanded in this level.
+    size_t frontier_size;
+
+    /// @brief Number of cycles seen for the first time, the frontier of the next level.
+    size_t discovered;
+
+    std::chrono::milliseconds elapsed;
+};
+
+/// @brief Level-synchronous breadth-first search over the graph where every cycle points to the cycles
+/// reached by perturbing a single cell of one of its frames. The cycles of a frontier are expanded in
+/// parallel and deduplicated through one shared concurrent set, the cycles each worker saw first are
+/// then merged in sorted order, so the frontiers and the result do not depend on the thread count.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class ParallelOrbitSearch
+{
+
+private:
+
+    constexpr static uint32_t CheckpointMagic = 0x4F4C4F47; // "GOLO"
+
+    OrbitSearchOptions m_options;
+
+    WorkStealingScheduler m_scheduler;
+
+    std::vector<OrbitLevel> m_levels;
+
+    std::vector<Cycle<Ts>> m_cycles;
+
+    PerturbationStore<Ts> m_perturbations;
+
+    /// @brief Id of an expanded cycle and the ids its perturbations lead to, both as handed out by the visited set.
+    struct RecordedRow
+    {
+        uint32_t id;
+        std::vector<uint32_t> destinations;
+    };
+
+    [[nodiscard]] static std::chrono::milliseconds since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    }
+
+    void save_checkpoint(const ConcurrentCycleSet<Ts> &visited, const std::vector<Cycle<Ts>> &frontier) const
+    {
+        std::vector<Cycle<Ts>> cycles = visited.snapshot();
+        std::sort(cycles.begin(), cycles.end(), typename Cycle<Ts>::Less());
+
+        checkpoint::write_atomically(m_options.checkpoint_path, [&](std::ostream &os)
+        {
+            checkpoint::write_header(os, CheckpointMagic, Ts);
+            checkpoint::write_cycles<Ts>(os, cycles);
+            checkpoint::write_cycles<Ts>(os, frontier);
+        });
+    }
+
+    void load_checkpoint(ConcurrentCycleSet<Ts> &visited, std::vector<Cycle<Ts>> &frontier) const
+    {
+        auto is = checkpoint::open(m_options.checkpoint_path);
+        checkpoint::read_header(is, CheckpointMagic, Ts);
+
+        for (const auto &cycle : checkpoint::read_cycles<Ts>(is))
+            visited.insert(cycle);
+        frontier = checkpoint::read_cycles<Ts>(is);
+    }
+
+public:
+
+    explicit ParallelOrbitSearch(const OrbitSearchOptions &options = {})
+    : m_options(options)
+    , m_scheduler(options.thread_count)
+    {
+
+    }
+
+    [[nodiscard]] size_t thread_count() const
+    {
+        return m_scheduler.thread_count();
+    }
+
+    /// @brief Frontier sizes and timings of the levels expanded by the last explore.
+    [[nodiscard]] const std::vector<OrbitLevel>& levels() const
+    {
+        return m_levels;
+    }
+
+    /// @brief Every cycle found by the last explore in sorted order.
+    [[nodiscard]] const std::vector<Cycle<Ts>>& cycles() const
+    {
+        return m_cycles;
+    }
+
+    /// @brief Perturbation outcomes recorded by the last explore when record_perturbations is set,
+    /// ids are indices into cycles().
+    [[nodiscard]] const PerturbationStore<Ts>& perturbations() const
+    {
+        return m_perturbations;
+    }
+
+    /// @brief Find every cycle reachable from the seeds, the seeds included.
+    [[nodiscard]] CycleSet<Ts> explore(std::vector<Cycle<Ts>> seeds)
+    {
+        m_levels.clear();
+
+        ConcurrentCycleSet<Ts> visited;
+        std::vector<Cycle<Ts>> frontier;
+
+        if (m_options.resume && std::filesystem::exists(m_options.checkpoint_path))
+        {
+            load_checkpoint(visited, frontier);
+        }
+        else
+        {
+            std::sort(seeds.begin(), seeds.end(), typename Cycle<Ts>::Less());
+            for (auto &seed : seeds)
+            {
+                if (visited.insert(seed).second)
+                    frontier.push_back(std::move(seed));
+            }
+        }
+
+        std::vector<std::vector<Cycle<Ts>>> candidates(m_scheduler.thread_count());
+        std::vector<std::vector<RecordedRow>> recorded(m_scheduler.thread_count());
+
+        while (!frontier.empty())
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            // Whichever worker inserts a cycle first owns it, so no cycle is collected twice.
+            m_scheduler.run(frontier.size(), [&](size_t worker_index, size_t cycle_index)
+            {
+                auto sweep = GameOfLife<Ts>::perturb_cycle(frontier[cycle_index].frames());
+
+                std::vector<uint32_t> ids(sweep.cycles.size());
+                for (size_t i = 0; i < sweep.cycles.size(); ++i)
+                {
+                    const auto [id, inserted] = visited.insert(sweep.cycles[i]);
+                    ids[i] = id;
+                    if (inserted)
+                        candidates[worker_index].push_back(std::move(sweep.cycles[i]));
+                }
+
+                if (m_options.record_perturbations)
+                {
+                    RecordedRow row { *visited.find(frontier[cycle_index]), {} };
+                    row.destinations.reserve(sweep.outcomes.size());
+                    for (const auto outcome : sweep.outcomes)
+                        row.destinations.push_back(ids[outcome]);
+                    recorded[worker_index].push_back(std::move(row));
+                }
+            });
+
+            std::vector<Cycle<Ts>> next;
+            for (auto &worker_candidates : candidates)
+            {
+                next.insert(next.end(),
+                    std::make_move_iterator(worker_candidates.begin()),
+                    std::make_move_iterator(worker_candidates.end()));
+                worker_candidates.clear();
+            }
+
+            std::sort(next.begin(), next.end(), typename Cycle<Ts>::Less());
+
+            const OrbitLevel level { frontier.size(), next.size(), since(start) };
+            m_levels.push_back(level);
+            frontier = std::move(next);
+
+            if (m_options.report_progress)
+            {
+                std::cout << "Level " << m_levels.size() - 1 << ": expanded " << level.frontier_size
+                          << ", discovered " << level.discovered << ", elapsed(ms)=" << level.elapsed.count() << '\n';
+            }
+
+            if (!m_options.checkpoint_path.empty())
+                save_checkpoint(visited, frontier);
+        }
+
+        m_cycles = visited.finalize();
+
+        std::vector<uint32_t> periods;
+        periods.reserve(m_cycles.size());
+        for (const auto &cycle : m_cycles)
+            periods.push_back(static_cast<uint32_t>(cycle.frames().size()));
+        m_perturbations = PerturbationStore<Ts>(std::move(periods));
+
+        for (auto &worker_rows : recorded)
+        {
+            for (const auto &recorded_row : worker_rows)
+            {
+                const uint32_t id = visited.final_id(recorded_row.id);
+                auto row = m_perturbations.row(id);
+                for (size_t i = 0; i < row.size(); ++i)
+                    row[i] = visited.final_id(recorded_row.destinations[i]);
+                m_perturbations.set_complete(id);
+            }
+            worker_rows.clear();
+        }
+
+        return CycleSet<Ts>(m_cycles.begin(), m_cycles.end());
+    }
+};
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include <checkpoint.hpp>
+#include <cycle.hpp>
+#include <cycle_catalogue.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <work_stealing.hpp>
+
+/// @brief Outcome of every single cell perturbation of every frame of a set of cycles. The
+/// destination cycle id of perturbing cell c of frame f of cycle i lives at
+/// offset(i) + f * CellCount + c of one flat array, so the writers and analysis passes look
+/// outcomes up instead of simulating them again. Frames are indexed in the ascending order in
+/// which cycles and catalogues keep them.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class PerturbationStore
+{
+
+private:
+
+    constexpr static uint32_t BinaryMagic = 0x504C4F47; // "GOLP"
+
+    /// @brief Destination of a perturbation that is not known yet.
+    constexpr static uint32_t Unknown = std::numeric_limits<uint32_t>::max();
+
+    std::vector<uint32_t> m_periods;
+
+    std::vector<uint64_t> m_offsets;
+
+    std::vector<uint32_t> m_destinations;
+
+    /// @brief Whether the row of a cycle holds its outcomes.
+    std::vector<uint8_t> m_complete;
+
+    static void compute_row(const CycleCatalogue<Ts> &catalogue, uint32_t id, std::span<uint32_t> row)
+    {
+        const auto sweep = GameOfLife<Ts>::perturb_cycle(catalogue.frames(id));
+
+        std::vector<uint32_t> ids(sweep.cycles.size());
+        for (size_t i = 0; i < sweep.cycles.size(); ++i)
+            ids[i] = catalogue.id(sweep.cycles[i]);
+
+        for (size_t i = 0; i < row.size(); ++i)
+            row[i] = ids[sweep.outcomes[i]];
+    }
+
+public:
+
+    PerturbationStore() = default;
+
+    /// @brief Store where no outcome is known yet.
+    /// @param periods Period of every cycle, the index is the cycle id.
+    explicit PerturbationStore(std::vector<uint32_t> periods)
+    : m_periods(std::move(periods))
+    , m_complete(m_periods.size(), 0)
+    {
+        m_offsets.reserve(m_periods.size() + 1);
+        m_offsets.push_back(0);
+        for (const auto period : m_periods)
+            m_offsets.push_back(m_offsets.back() + uint64_t(period) * Frame<Ts>::CellCount);
+        m_destinations.assign(m_offsets.back(), Unknown);
+    }
+
+    /// @brief Simulate every perturbation of every cycle of a catalogue in parallel.
+    /// @param thread_count Number of threads, zero picks the hardware concurrency.
+    [[nodiscard]] static PerturbationStore compute(const CycleCatalogue<Ts> &catalogue, size_t thread_count = 0)
+    {
+        std::vector<uint32_t> periods(catalogue.size());
+        for (uint32_t id = 0; id < catalogue.size(); ++id)
+            periods[id] = catalogue.period(id);
+
+        PerturbationStore store(std::move(periods));
+        store.fill_missing(catalogue, thread_count);
+        return store;
+    }
+
+    /// @brief Move the rows of a store whose ids index cycles over to the ids of a catalogue
+    /// holding all of them. Catalogue cycles without a row are simulated.
+    /// @param cycles Cycle of every id of this store.
+    [[nodiscard]] PerturbationStore remapped(
+        const CycleCatalogue<Ts> &catalogue,
+        std::span<const Cycle<Ts>> cycles,
+        size_t thread_count = 0) const
+    {
+        std::vector<uint32_t> ids(cycles.size());
+        for (size_t i = 0; i < cycles.size(); ++i)
+            ids[i] = catalogue.id(cycles[i]);
+
+        std::vector<uint32_t> periods(catalogue.size());
+        for (uint32_t id = 0; id < catalogue.size(); ++id)
+            periods[id] = catalogue.period(id);
+
+        PerturbationStore store(std::move(periods));
+        for (uint32_t id = 0; id < size(); ++id)
+        {
+            if (!complete(id))
+                continue;
+
+            const auto source = destinations(id);
+            auto target = store.row(ids[id]);
+            for (size_t i = 0; i < source.size(); ++i)
+                target[i] = ids[source[i]];
+            store.m_complete[ids[id]] = 1;
+        }
+
+        store.fill_missing(catalogue, thread_count);
+        return store;
+    }
+
+    /// @brief Simulate the rows that are not known yet, the ids must be those of the catalogue.
+    void fill_missing(const CycleCatalogue<Ts> &catalogue, size_t thread_count = 0)
+    {
+        std::vector<uint32_t> missing;
+        for (uint32_t id = 0; id < size(); ++id)
+        {
+            if (!complete(id))
+                missing.push_back(id);
+        }
+
+        WorkStealingScheduler scheduler(thread_count);
+        scheduler.run(missing.size(), [&](size_t, size_t index)
+        {
+            compute_row(catalogue, missing[index], row(missing[index]));
+            m_complete[missing[index]] = 1;
+        });
+    }
+
+    /// @brief Writable outcomes of every frame of a cycle, mark the row with set_complete once filled.
+    [[nodiscard]] std::span<uint32_t> row(uint32_t id)
+    {
+        return { m_destinations.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id] };
+    }
+
+    void set_complete(uint32_t id)
+    {
+        m_complete[id] = 1;
+    }
+
+    [[nodiscard]] bool complete(uint32_t id) const
+    {
+        return 0 != m_complete[id];
+    }
+
+    /// @brief Number of cycles.
+    [[nodiscard]] size_t size() const
+    {
+        return m_periods.size();
+    }
+
+    [[nodiscard]] uint32_t period(uint32_t id) const
+    {
+        return m_periods[id];
+    }
+
+    /// @return Destinations of every cell of every frame of a cycle, frame after frame.
+    [[nodiscard]] std::span<const uint32_t> destinations(uint32_t id) const
+    {
+        return { m_destinations.data() + m_offsets[id], m_offsets[id + 1] - m_offsets[id] };
+    }
+
+    /// @return Destinations of every cell of one frame of a cycle.
+    [[nodiscard]] std::span<const uint32_t> destinations(uint32_t id, size_t frame_index) const
+    {
+        return destinations(id).subspan(frame_index * Frame<Ts>::CellCount, Frame<Ts>::CellCount);
+    }
+
+    /// @return Id of the cycle reached after toggling a cell of a frame of a cycle.
+    [[nodiscard]] uint32_t destination(uint32_t id, size_t frame_index, size_t cell) const
+    {
+        return m_destinations[m_offsets[id] + frame_index * Frame<Ts>::CellCount + cell];
+    }
+
+    /// @brief Whether the store was built for the cycles of the catalogue.
+    [[nodiscard]] bool matches(const CycleCatalogue<Ts> &catalogue) const
+    {
+        if (catalogue.size() != size())
+            return false;
+        for (uint32_t id = 0; id < size(); ++id)
+        {
+            if (catalogue.period(id) != m_periods[id])
+                return false;
+        }
+        return true;
+    }
+
+    /// @brief Write the periods, completion flags and outcomes, atomically like a checkpoint.
+    void save(const std::filesystem::path &path) const
+    {
+        checkpoint::write_atomically(path, [&](std::ostream &os)
+        {
+            checkpoint::write_header(os, BinaryMagic, Ts);
+            checkpoint::write_value<uint64_t>(os, size());
+            os.write(reinterpret_cast<const char*>(m_periods.data()), m_periods.size() * sizeof(uint32_t));
+            os.write(reinterpret_cast<const char*>(m_complete.data()), m_complete.size());
+            os.write(reinterpret_cast<const char*>(m_destinations.data()), m_destinations.size() * sizeof(uint32_t));
+        });
+    }
+
+    /// @brief Read a store written by save.
+    [[nodiscard]] static PerturbationStore load(const std::filesystem::path &path)
+    {
+        auto is = checkpoint::open(path);
+        checkpoint::read_header(is, BinaryMagic, Ts);
+
+        std::vector<uint32_t> periods(checkpoint::read_value<uint64_t>(is));
+        if (!is.read(reinterpret_cast<char*>(periods.data()), periods.size() * sizeof(uint32_t)))
+            throw std::runtime_error("Perturbation store is truncated");
+
+        PerturbationStore store(std::move(periods));
+        if (!is.read(reinterpret_cast<char*>(store.m_complete.data()), store.m_complete.size())
+            || !is.read(reinterpret_cast<char*>(store.m_destinations.data()), store.m_destinations.size() * sizeof(uint32_t)))
+            throw std::runtime_error("Perturbation store is truncated");
+        return store;
+    }
+};
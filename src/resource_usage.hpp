@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <sys/resource.h>
+
+/// @return Peak resident set size of the process in bytes, zero if it can not be queried.
+[[nodiscard]] inline size_t peak_resident_bytes()
+{
+    rusage usage{};
+    if (0 != getrusage(RUSAGE_SELF, &usage))
+        return 0;
+
+    // Linux reports the maximum resident set size in kilobytes.
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
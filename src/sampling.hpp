@@ -0,0 +1,298 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <absl/numeric/int128.h>
+#include <concurrent_cycle_set.hpp>
+#include <cycle.hpp>
+#include <cycle_memo.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <work_stealing.hpp>
+
+/// @brief Counter-based random numbers: value i of a stream is a pure function of (seed, stream, i),
+/// so every task draws the same numbers no matter which thread runs it or in which order.
+class CounterRandom
+{
+
+private:
+
+    uint64_t m_key;
+
+    uint64_t m_counter = 0;
+
+    [[nodiscard]] constexpr static uint64_t mix(uint64_t x)
+    {
+        // SplitMix64 finalizer.
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+public:
+
+    constexpr CounterRandom(uint64_t seed, uint64_t stream)
+    : m_key(mix(seed + mix(stream + 0x9E3779B97F4A7C15ull)))
+    {
+
+    }
+
+    [[nodiscard]] constexpr uint64_t next()
+    {
+        return mix(m_key + 0x9E3779B97F4A7C15ull * ++m_counter);
+    }
+
+    [[nodiscard]] constexpr absl::uint128 next128()
+    {
+        const uint64_t high = next();
+        return absl::MakeUint128(high, next());
+    }
+
+    /// @return Number in [0, bound).
+    [[nodiscard]] uint64_t below(uint64_t bound)
+    {
+        return static_cast<uint64_t>((absl::uint128(next()) * bound) >> 64);
+    }
+};
+
+enum class SamplingMode
+{
+    /// @brief Every board is equally likely, nearly all samples have a density close to one half.
+    Uniform,
+
+    /// @brief Live cell counts 0..CellCount take turns, the cells are placed uniformly.
+    Stratified,
+
+    /// @brief Runs of block_length consecutive states starting at uniformly random states, neighbouring
+    /// states share most of their trajectories so the memo hits more often.
+    Blocks
+};
+
+struct SamplingOptions
+{
+    /// @brief Number of worker threads, zero picks the hardware concurrency.
+    size_t thread_count = 0;
+
+    SamplingMode mode = SamplingMode::Uniform;
+
+    uint64_t seed = 0;
+
+    /// @brief Upper bound on the number of simulated start states.
+    uint64_t max_samples = uint64_t(1) << 24;
+
+    /// @brief Number of samples handed out as one task.
+    uint64_t task_size = uint64_t(1) << 12;
+
+    /// @brief Number of tasks between two early stopping checks.
+    size_t round_tasks = 256;
+
+    /// @brief Length of a run of consecutive states in Blocks mode.
+    uint64_t block_length = uint64_t(1) << 10;
+
+    /// @brief Stop once a round finds fewer new cycles per million samples, zero never stops early.
+    double min_new_cycles_per_million = 0;
+
+    /// @brief Byte budget of the memo owned by each worker.
+    size_t memo_memory_limit = 64ull << 20;
+
+    /// @brief Print the statistics of every round.
+    bool report_progress = false;
+};
+
+/// @brief Statistics of one round of sampling.
+struct SamplingRound
+{
+    uint64_t samples;
+    size_t new_cycles;
+    double new_cycles_per_million;
+    std::chrono::milliseconds elapsed;
+};
+
+/// @brief Draws start states over the whole 2^(Ts*Ts) range in parallel and collects the cycles they
+/// reach. Sample j of task t comes from the random stream (seed, t), and the early stopping check runs
+/// between rounds of tasks on the merged cycle set, so the result only depends on the options.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class ParallelSampler
+{
+
+private:
+
+    struct Worker
+    {
+        GameOfLife<Ts> game;
+        std::vector<Frame<Ts>> trajectory;
+        CycleMemo<Ts> memo;
+
+        /// @brief Number of memo cycles already handed to the shared set.
+        size_t published = 0;
+
+        explicit Worker(size_t memo_memory_limit)
+        : memo(memo_memory_limit)
+        {
+
+        }
+    };
+
+    SamplingOptions m_options;
+
+    WorkStealingScheduler m_scheduler;
+
+    std::vector<SamplingRound> m_rounds;
+
+    /// @return Uniformly random board.
+    [[nodiscard]] static typename Frame<Ts>::State random_state(CounterRandom &random)
+    {
+        if constexpr (Frame<Ts>::CellCount <= 128)
+            return random.next128() & Frame<Ts>::BoardMask;
+        else
+        {
+            const uint256 high = random.next128();
+            return ((high << 128) | uint256(random.next128())) & Frame<Ts>::BoardMask;
+        }
+    }
+
+    /// @return Board with exactly live_cells live cells chosen uniformly by Floyd's algorithm.
+    [[nodiscard]] static Frame<Ts> random_frame(CounterRandom &random, size_t live_cells)
+    {
+        Frame<Ts> frame;
+        for (size_t j = Frame<Ts>::CellCount - live_cells; j < Frame<Ts>::CellCount; ++j)
+        {
+            const auto cell = static_cast<size_t>(random.below(j + 1));
+            frame.set(frame.get(cell) ? j : cell);
+        }
+        return frame;
+    }
+
+    void run_task(Worker &worker, uint64_t task_index, uint64_t sample_begin, uint64_t sample_end) const
+    {
+        CounterRandom random(m_options.seed, task_index);
+
+        const auto simulate = [&](const Frame<Ts> &frame)
+        {
+            worker.game.set(frame);
+            (void)worker.game.find_cycle(worker.memo, worker.trajectory);
+        };
+
+        switch (m_options.mode)
+        {
+            case SamplingMode::Uniform:
+                for (uint64_t sample = sample_begin; sample < sample_end; ++sample)
+                    simulate(Frame<Ts>(random_state(random)));
+                break;
+
+            case SamplingMode::Stratified:
+                for (uint64_t sample = sample_begin; sample < sample_end; ++sample)
+                {
+                    // Fill the sparser half and flip, keeps the number of draws at most half the cells.
+                    const size_t live_cells = sample % (Frame<Ts>::CellCount + 1);
+                    if (2 * live_cells <= Frame<Ts>::CellCount)
+                        simulate(random_frame(random, live_cells));
+                    else
+                        simulate(Frame<Ts>(~random_frame(random, Frame<Ts>::CellCount - live_cells).get() & Frame<Ts>::BoardMask));
+                }
+                break;
+
+            case SamplingMode::Blocks:
+            {
+                const uint64_t block_length = std::max<uint64_t>(m_options.block_length, 1);
+                typename Frame<Ts>::State state = 0;
+                for (uint64_t sample = sample_begin; sample < sample_end; ++sample, ++state)
+                {
+                    if ((sample - sample_begin) % block_length == 0)
+                        state = random_state(random);
+                    simulate(Frame<Ts>(state & Frame<Ts>::BoardMask));
+                }
+                break;
+            }
+        }
+    }
+
+public:
+
+    explicit ParallelSampler(const SamplingOptions &options = {})
+    : m_options(options)
+    , m_scheduler(options.thread_count)
+    {
+
+    }
+
+    [[nodiscard]] size_t thread_count() const
+    {
+        return m_scheduler.thread_count();
+    }
+
+    /// @brief Statistics of every round of the last run.
+    [[nodiscard]] const std::vector<SamplingRound>& rounds() const
+    {
+        return m_rounds;
+    }
+
+    /// @brief Number of start states simulated by the last run.
+    [[nodiscard]] uint64_t samples_taken() const
+    {
+        uint64_t total = 0;
+        for (const auto &round : m_rounds)
+            total += round.samples;
+        return total;
+    }
+
+    /// @brief Sample until max_samples are taken or a round finds too few new cycles.
+    [[nodiscard]] CycleSet<Ts> sample()
+    {
+        m_rounds.clear();
+
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (size_t i = 0; i < m_scheduler.thread_count(); ++i)
+            workers.push_back(std::make_unique<Worker>(m_options.memo_memory_limit));
+
+        ConcurrentCycleSet<Ts> cycles;
+
+        const uint64_t task_size = std::max<uint64_t>(m_options.task_size, 1);
+        const uint64_t task_count = (m_options.max_samples + task_size - 1) / task_size;
+        const uint64_t round_tasks = std::max<size_t>(m_options.round_tasks, 1);
+
+        for (uint64_t round_begin = 0; round_begin < task_count; round_begin += round_tasks)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const uint64_t round_end = std::min(round_begin + round_tasks, task_count);
+            const size_t known_cycles = cycles.size();
+
+            m_scheduler.run(round_end - round_begin, [&](size_t worker_index, size_t task_offset)
+            {
+                Worker &worker = *workers[worker_index];
+                const uint64_t task_index = round_begin + task_offset;
+                const uint64_t sample_begin = task_index * task_size;
+                run_task(worker, task_index, sample_begin, std::min(sample_begin + task_size, m_options.max_samples));
+
+                // Only cycles the memo has not seen before can be new to the shared set.
+                for (; worker.published < worker.memo.cycles().size(); ++worker.published)
+                    cycles.insert(worker.memo.cycle(worker.published));
+            });
+
+            SamplingRound round{};
+            round.samples = std::min(round_end * task_size, m_options.max_samples) - round_begin * task_size;
+            round.new_cycles = cycles.size() - known_cycles;
+            round.new_cycles_per_million = 1e6 * static_cast<double>(round.new_cycles) / static_cast<double>(round.samples);
+            round.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            m_rounds.push_back(round);
+
+            if (m_options.report_progress)
+            {
+                std::cout << "Sampled " << round_end * 100 / task_count << "%, new cycles: " << round.new_cycles
+                          << " (" << round.new_cycles_per_million << " per million), total: " << cycles.size()
+                          << ", elapsed(ms)=" << round.elapsed.count() << '\n';
+            }
+
+            if (round.new_cycles_per_million < m_options.min_new_cycles_per_million)
+                break;
+        }
+
+        const auto sorted = cycles.finalize();
+        return CycleSet<Ts>(sorted.begin(), sorted.end());
+    }
+};
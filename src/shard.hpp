@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cycle.hpp>
+#include <cycle_catalogue.hpp>
+#include <cycle_database.hpp>
+#include <frame.hpp>
+
+/// @brief Part index of count of a run split over several processes, see EnumerationOptions::shard_index.
+struct Shard
+{
+    uint64_t index = 0;
+
+    uint64_t count = 1;
+
+    /// @brief Parse "i/k" with i < k.
+    [[nodiscard]] static std::optional<Shard> parse(std::string_view text)
+    {
+        const auto slash = text.find('/');
+        if (std::string_view::npos == slash)
+            return std::nullopt;
+
+        Shard shard;
+        const auto parse_number = [](std::string_view digits, uint64_t &value)
+        {
+            const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+            return std::errc() == error && end == digits.data() + digits.size();
+        };
+        if (!parse_number(text.substr(0, slash), shard.index)
+            || !parse_number(text.substr(slash + 1), shard.count)
+            || shard.index >= shard.count)
+            return std::nullopt;
+        return shard;
+    }
+};
+
+/// @brief Merge the cycle databases written by the shards of a run into one catalogue. Each database
+/// is walked in the order of its canonical index and the walks are merged on the canonical frame with
+/// a heap, so equal cycles from several shards arrive next to each other and are kept once. Ids are
+/// assigned in canonical frame order, which is the order build_catalogue gives the same cycles, so
+/// the result does not depend on how the run was split.
+/// @param inputs Databases of the shards, in any order.
+template<size_t Ts>
+[[nodiscard]] CycleCatalogue<Ts> merge_cycle_databases(std::span<const std::filesystem::path> inputs)
+{
+    std::vector<CycleDatabase<Ts>> databases;
+    databases.reserve(inputs.size());
+    for (const auto &path : inputs)
+        databases.emplace_back(path);
+
+    size_t upper_bound = 0;
+    for (const auto &database : databases)
+        upper_bound += database.size();
+    CycleCatalogue<Ts> catalogue(upper_bound);
+
+    // Position of every database in its canonical index.
+    std::vector<size_t> positions(databases.size(), 0);
+
+    const auto canonical = [&](size_t source)
+    {
+        return databases[source].frames(databases[source].canonical_id(positions[source]))[0];
+    };
+    const auto greater = [&](size_t a, size_t b)
+    {
+        return canonical(b) < canonical(a);
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+
+    for (size_t source = 0; source < databases.size(); ++source)
+    {
+        if (databases[source].size() > 0)
+            heap.push(source);
+    }
+
+    std::optional<uint32_t> previous;
+    while (!heap.empty())
+    {
+        const size_t source = heap.top();
+        heap.pop();
+
+        const auto frames = databases[source].frames(databases[source].canonical_id(positions[source]));
+        if (previous && catalogue.frames(*previous)[0] == frames[0])
+        {
+            if (!std::ranges::equal(catalogue.frames(*previous), frames))
+                throw std::runtime_error("Shards disagree on the cycle of a canonical frame: " + inputs[source].string());
+        }
+        else
+        {
+            previous = catalogue.insert(Cycle<Ts>::from_normalized(frames)).first;
+        }
+
+        if (++positions[source] < databases[source].size())
+            heap.push(source);
+    }
+
+    return catalogue;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+#include <cycle.hpp>
+#include <frame.hpp>
+#include <game_of_life.hpp>
+#include <work_stealing.hpp>
+
+/// @brief Complete functional graph of a small torus. The successor of every one of the
+/// 2^(Ts*Ts) states is stored, which gives every cycle, the transient length of every
+/// state and the basin size of every attractor in a single linear pass.
+/// @tparam Ts size of the board, 5x5 already needs 128 MB per state array.
+template<size_t Ts>
+requires(Ts <= 5)
+class SuccessorTable
+{
+
+public:
+
+    constexpr static uint64_t StateCount = uint64_t(1) << Frame<Ts>::CellCount;
+
+private:
+
+    constexpr static uint32_t Unvisited = std::numeric_limits<uint32_t>::max();
+
+    constexpr static uint32_t OnPath = Unvisited - 1;
+
+    constexpr static uint64_t ChunkSize = 1 << 16;
+
+    std::vector<uint32_t> m_successors;
+
+    /// @brief Index of the cycle every state ends up in.
+    std::vector<uint32_t> m_attractors;
+
+    /// @brief Number of generations before every state reaches its cycle, saturates at the type maximum.
+    std::vector<uint16_t> m_transients;
+
+    std::vector<Cycle<Ts>> m_cycles;
+
+    std::vector<uint64_t> m_basin_sizes;
+
+    void fill_successors(size_t thread_count)
+    {
+        m_successors.resize(StateCount);
+
+        WorkStealingScheduler scheduler(thread_count);
+        scheduler.run((StateCount + ChunkSize - 1) / ChunkSize, [&](size_t, size_t chunk_index)
+        {
+            const uint64_t begin = chunk_index * ChunkSize;
+            const uint64_t end = std::min(begin + ChunkSize, StateCount);
+
+            for (uint64_t state = begin; state < end; ++state)
+            {
+                const GameOfLife<Ts> game { Frame<Ts>(state) };
+                m_successors[state] = static_cast<uint32_t>(absl::Uint128Low64(game.next().get()));
+            }
+        });
+    }
+
+    void colour()
+    {
+        m_attractors.assign(StateCount, Unvisited);
+        m_transients.assign(StateCount, 0);
+
+        // Cycles in the order they were found, equivalent cycles are merged afterwards.
+        std::vector<Cycle<Ts>> raw_cycles;
+        std::vector<uint32_t> path;
+        std::vector<Frame<Ts>> cycle_frames;
+
+        for (uint64_t start = 0; start < StateCount; ++start)
+        {
+            if (Unvisited != m_attractors[start])
+                continue;
+
+            uint32_t state = static_cast<uint32_t>(start);
+            while (Unvisited == m_attractors[state])
+            {
+                m_attractors[state] = OnPath;
+                path.push_back(state);
+                state = m_successors[state];
+            }
+
+            if (OnPath == m_attractors[state])
+            {
+                // The walk closed on itself, everything from here on the path is a new cycle.
+                const auto raw_index = static_cast<uint32_t>(raw_cycles.size());
+                uint32_t cycle_state = state;
+                do
+                {
+                    cycle_frames.emplace_back(cycle_state);
+                    m_attractors[cycle_state] = raw_index;
+                    cycle_state = m_successors[cycle_state];
+                } while (cycle_state != state);
+
+                raw_cycles.emplace_back(cycle_frames);
+                cycle_frames.clear();
+
+                while (path.back() != state)
+                    path.pop_back();
+                path.pop_back();
+            }
+
+            // Unwind the transient, each state is one generation further from the cycle than its successor.
+            while (!path.empty())
+            {
+                const uint32_t transient_state = path.back();
+                const uint32_t successor = m_successors[transient_state];
+                path.pop_back();
+
+                m_attractors[transient_state] = m_attractors[successor];
+                m_transients[transient_state] = m_transients[successor] == std::numeric_limits<uint16_t>::max()
+                    ? m_transients[successor]
+                    : m_transients[successor] + 1;
+            }
+        }
+
+        // Symmetric images of a cycle normalize to the same cycle, number them in sorted order.
+        m_cycles = raw_cycles;
+        std::sort(m_cycles.begin(), m_cycles.end(), typename Cycle<Ts>::Less());
+        m_cycles.erase(
+            std::unique(m_cycles.begin(), m_cycles.end(), typename Cycle<Ts>::Equal()),
+            m_cycles.end());
+
+        std::unordered_map<Cycle<Ts>, uint32_t, typename Cycle<Ts>::Hash, typename Cycle<Ts>::Equal> indices;
+        for (size_t i = 0; i < m_cycles.size(); ++i)
+            indices[m_cycles[i]] = static_cast<uint32_t>(i);
+
+        std::vector<uint32_t> canonical_indices;
+        for (const auto &raw_cycle : raw_cycles)
+            canonical_indices.push_back(indices.at(raw_cycle));
+
+        m_basin_sizes.assign(m_cycles.size(), 0);
+        for (auto &attractor : m_attractors)
+        {
+            attractor = canonical_indices[attractor];
+            ++m_basin_sizes[attractor];
+        }
+    }
+
+public:
+
+    /// @brief Build the table and analyse it.
+    /// @param thread_count Number of threads used to fill the successors, zero picks the hardware concurrency.
+    explicit SuccessorTable(size_t thread_count = 0)
+    {
+        fill_successors(thread_count);
+        colour();
+    }
+
+    [[nodiscard]] uint32_t successor(uint32_t state) const
+    {
+        return m_successors[state];
+    }
+
+    /// @return Index into cycles() of the cycle the state ends up in.
+    [[nodiscard]] uint32_t attractor(uint32_t state) const
+    {
+        return m_attractors[state];
+    }
+
+    /// @return Number of generations before the state reaches its cycle.
+    [[nodiscard]] uint16_t transient(uint32_t state) const
+    {
+        return m_transients[state];
+    }
+
+    /// @brief Every normalized cycle of the torus in sorted order.
+    [[nodiscard]] const std::vector<Cycle<Ts>>& cycles() const
+    {
+        return m_cycles;
+    }
+
+    /// @brief Number of states that end up in each of cycles().
+    [[nodiscard]] const std::vector<uint64_t>& basin_sizes() const
+    {
+        return m_basin_sizes;
+    }
+};
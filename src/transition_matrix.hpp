@@ -0,0 +1,251 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <numeric>
+#include <ostream>
+#include <span>
+#include <vector>
+#include <Eigen/Sparse>
+#include <async_writer.hpp>
+#include <checkpoint.hpp>
+#include <cycle_catalogue.hpp>
+#include <frame.hpp>
+#include <perturbation_store.hpp>
+#include <work_stealing.hpp>
+
+/// @brief Perturbation transition matrix between the cycles of a catalogue in compressed sparse
+/// row form. Row i counts into which cycle every single cell flip of every frame of cycle i leads,
+/// with the T*N^2 perturbations leaving the row subtracted on the diagonal. A row has at most
+/// T*N^2 non-zeros, so building and writing cost O(non-zeros) instead of O(cycles^2). The rows
+/// are counted from a perturbation store, which the orbit search can fill during discovery.
+/// @tparam Ts size of the board
+template<size_t Ts>
+class TransitionMatrix
+{
+
+private:
+
+    constexpr static uint32_t BinaryMagic = 0x4D4C4F47; // "GOLM"
+
+    std::vector<uint64_t> m_row_offsets;
+
+    std::vector<uint32_t> m_columns;
+
+    /// @brief Number of perturbations into each column, minus T*N^2 on the diagonal.
+    std::vector<int64_t> m_frequencies;
+
+    std::vector<uint32_t> m_periods;
+
+    struct Entry
+    {
+        uint32_t column;
+        int64_t frequency;
+    };
+
+    [[nodiscard]] static std::vector<Entry> compute_row(const PerturbationStore<Ts> &perturbations, uint32_t id)
+    {
+        const auto outcomes = perturbations.destinations(id);
+        std::vector<uint32_t> destinations(outcomes.begin(), outcomes.end());
+        // Make sure the diagonal is present even if no perturbation returns to the cycle.
+        destinations.push_back(id);
+
+        std::sort(destinations.begin(), destinations.end());
+
+        std::vector<Entry> row;
+        for (size_t i = 0; i < destinations.size();)
+        {
+            size_t j = i;
+            while (j < destinations.size() && destinations[j] == destinations[i])
+                ++j;
+
+            int64_t frequency = static_cast<int64_t>(j - i);
+            if (destinations[i] == id)
+                frequency -= 1 + static_cast<int64_t>(perturbations.period(id) * Frame<Ts>::CellCount);
+
+            row.push_back({ destinations[i], frequency });
+            i = j;
+        }
+        return row;
+    }
+
+    static void append_zeros(OutputBuffer &buffer, uint64_t count)
+    {
+        if (1 == count)
+        {
+            buffer.append("0 ");
+        }
+        else if (count > 1)
+        {
+            buffer.append("0$");
+            buffer.append(count);
+            buffer.append(' ');
+        }
+    }
+
+public:
+
+    /// @brief Simulate every perturbation of the catalogue and count the rows in parallel.
+    /// @param thread_count Number of threads, zero picks the hardware concurrency.
+    explicit TransitionMatrix(const CycleCatalogue<Ts> &catalogue, size_t thread_count = 0)
+    : TransitionMatrix(PerturbationStore<Ts>::compute(catalogue, thread_count), thread_count)
+    {
+
+    }
+
+    /// @brief Count the rows of known perturbation outcomes in parallel, nothing is simulated.
+    /// @param perturbations Complete outcomes, the ids are the row and column indices.
+    /// @param thread_count Number of threads, zero picks the hardware concurrency.
+    explicit TransitionMatrix(const PerturbationStore<Ts> &perturbations, size_t thread_count = 0)
+    {
+        const auto row_count = static_cast<uint32_t>(perturbations.size());
+
+        std::vector<std::vector<Entry>> rows(row_count);
+        WorkStealingScheduler scheduler(thread_count);
+        scheduler.run(row_count, [&](size_t, size_t id)
+        {
+            rows[id] = compute_row(perturbations, static_cast<uint32_t>(id));
+        });
+
+        m_row_offsets.reserve(row_count + 1);
+        m_row_offsets.push_back(0);
+        for (const auto &row : rows)
+            m_row_offsets.push_back(m_row_offsets.back() + row.size());
+
+        m_columns.reserve(m_row_offsets.back());
+        m_frequencies.reserve(m_row_offsets.back());
+        m_periods.reserve(row_count);
+        for (uint32_t id = 0; id < row_count; ++id)
+        {
+            for (const auto &entry : rows[id])
+            {
+                m_columns.push_back(entry.column);
+                m_frequencies.push_back(entry.frequency);
+            }
+            std::vector<Entry>().swap(rows[id]);
+            m_periods.push_back(perturbations.period(id));
+        }
+    }
+
+    [[nodiscard]] size_t rows() const
+    {
+        return m_periods.size();
+    }
+
+    [[nodiscard]] size_t non_zeros() const
+    {
+        return m_columns.size();
+    }
+
+    /// @return Columns of the entries of a row in ascending order.
+    [[nodiscard]] std::span<const uint32_t> columns(size_t row) const
+    {
+        return { m_columns.data() + m_row_offsets[row], m_row_offsets[row + 1] - m_row_offsets[row] };
+    }
+
+    /// @return Frequencies of the entries of a row, parallel to columns(row).
+    [[nodiscard]] std::span<const int64_t> frequencies(size_t row) const
+    {
+        return { m_frequencies.data() + m_row_offsets[row], m_row_offsets[row + 1] - m_row_offsets[row] };
+    }
+
+    /// @brief Period of the cycle of a row, an entry is a rate of frequency / period.
+    [[nodiscard]] uint32_t period(size_t row) const
+    {
+        return m_periods[row];
+    }
+
+    /// @return Matrix of rates, entry (i, j) is the frequency divided by the period of cycle i.
+    [[nodiscard]] Eigen::SparseMatrix<double, Eigen::RowMajor> sparse() const
+    {
+        std::vector<Eigen::Triplet<double>> triplets;
+        triplets.reserve(non_zeros());
+        for (size_t row = 0; row < rows(); ++row)
+        {
+            for (uint64_t i = m_row_offsets[row]; i < m_row_offsets[row + 1]; ++i)
+            {
+                triplets.emplace_back(
+                    static_cast<Eigen::Index>(row),
+                    static_cast<Eigen::Index>(m_columns[i]),
+                    static_cast<double>(m_frequencies[i]) / m_periods[row]);
+            }
+        }
+
+        Eigen::SparseMatrix<double, Eigen::RowMajor> matrix(
+            static_cast<Eigen::Index>(rows()),
+            static_cast<Eigen::Index>(rows()));
+        matrix.setFromTriplets(triplets.begin(), triplets.end());
+        return matrix;
+    }
+
+    /// @brief Write the matrix as binary CSR: header, row offsets, columns, frequencies and periods.
+    void write_binary(const std::filesystem::path &path) const
+    {
+        checkpoint::write_atomically(path, [&](std::ostream &os)
+        {
+            checkpoint::write_header(os, BinaryMagic, Ts);
+            checkpoint::write_value<uint64_t>(os, rows());
+            checkpoint::write_value<uint64_t>(os, non_zeros());
+            os.write(reinterpret_cast<const char*>(m_row_offsets.data()), m_row_offsets.size() * sizeof(uint64_t));
+            os.write(reinterpret_cast<const char*>(m_columns.data()), m_columns.size() * sizeof(uint32_t));
+            os.write(reinterpret_cast<const char*>(m_frequencies.data()), m_frequencies.size() * sizeof(int64_t));
+            os.write(reinterpret_cast<const char*>(m_periods.data()), m_periods.size() * sizeof(uint32_t));
+        });
+    }
+
+    /// @brief Append one row in the run-length text format read by the scripts. A run of k > 1
+    /// zeros is written as 0$k and rates that are not integers as reduced fractions.
+    void append_text_row(OutputBuffer &buffer, size_t row) const
+    {
+        // i'th element is the frequency at which current cycle ends up in cycle with index i.
+        const auto n = static_cast<int64_t>(m_periods[row] * Frame<Ts>::CellCount);
+
+        uint64_t zero_counter = 0;
+        uint64_t next_column = 0;
+
+        for (uint64_t i = m_row_offsets[row]; i < m_row_offsets[row + 1]; ++i)
+        {
+            zero_counter += m_columns[i] - next_column;
+            next_column = m_columns[i] + 1;
+
+            const int64_t scaled = m_frequencies[i] * static_cast<int64_t>(Ts * Ts);
+            if (0 == scaled)
+            {
+                ++zero_counter;
+                continue;
+            }
+
+            append_zeros(buffer, zero_counter);
+            zero_counter = 0;
+
+            if (0 == scaled % n)
+            {
+                buffer.append(scaled / n);
+            }
+            else
+            {
+                const int64_t d = std::gcd(scaled, n);
+                buffer.append(scaled / d);
+                buffer.append('/');
+                buffer.append(n / d);
+            }
+            buffer.append(' ');
+        }
+
+        append_zeros(buffer, zero_counter + rows() - next_column);
+        buffer.append('\n');
+    }
+
+    /// @brief Write the matrix in the run-length text format read by the scripts.
+    void write_text(std::ostream &os) const
+    {
+        OutputBuffer buffer;
+        for (size_t row = 0; row < rows(); ++row)
+        {
+            append_text_row(buffer, row);
+            os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <compare>
+#include <concepts>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <absl/numeric/int128.h>
+#include <types.hpp>
+
+/// @brief Unsigned 256-bit integer with the subset of the absl::uint128 interface that frames use,
+/// so boards of up to 16x16 cells can share the bit-parallel code of the smaller ones. Arithmetic
+/// wraps modulo 2^256 and shifts by 256 or more bits give zero. Bitwise operations work on whole
+/// AVX2 registers at run time and fall back to word loops in constant evaluation.
+class alignas(32) uint256
+{
+
+private:
+
+    /// @brief Little-endian words, word 0 holds bits [0, 64).
+    std::array<uint64_t, 4> m_words{};
+
+    template<class Operation>
+    [[nodiscard]] constexpr static uint256 wordwise(const uint256 &a, const uint256 &b, Operation operation)
+    {
+        uint256 result;
+        for (size_t i = 0; i < 4; ++i)
+            result.m_words[i] = operation(a.m_words[i], b.m_words[i]);
+        return result;
+    }
+
+#if defined(__AVX2__)
+    [[nodiscard]] i256 load() const
+    {
+        return _mm256_load_si256(reinterpret_cast<const i256*>(m_words.data()));
+    }
+
+    [[nodiscard]] static uint256 store(i256 value)
+    {
+        uint256 result;
+        _mm256_store_si256(reinterpret_cast<i256*>(result.m_words.data()), value);
+        return result;
+    }
+#endif
+
+public:
+
+    constexpr uint256() = default;
+
+    template<std::integral T>
+    constexpr uint256(T value)
+    {
+        m_words[0] = static_cast<uint64_t>(value);
+        // Negative values sign-extend like they do for absl::uint128.
+        if constexpr (std::is_signed_v<T>)
+        {
+            if (value < 0)
+                m_words[1] = m_words[2] = m_words[3] = ~uint64_t(0);
+        }
+    }
+
+    constexpr uint256(absl::uint128 value)
+    : m_words { absl::Uint128Low64(value), absl::Uint128High64(value), 0, 0 }
+    {
+
+    }
+
+    constexpr static uint256 from_words(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3)
+    {
+        uint256 result;
+        result.m_words = { w0, w1, w2, w3 };
+        return result;
+    }
+
+    [[nodiscard]] constexpr uint64_t word(size_t index) const
+    {
+        return m_words[index];
+    }
+
+    constexpr explicit operator uint64_t() const
+    {
+        return m_words[0];
+    }
+
+    constexpr explicit operator bool() const
+    {
+        return 0 != (m_words[0] | m_words[1] | m_words[2] | m_words[3]);
+    }
+
+    [[nodiscard]] constexpr int popcount() const
+    {
+        return std::popcount(m_words[0]) + std::popcount(m_words[1]) + std::popcount(m_words[2]) + std::popcount(m_words[3]);
+    }
+
+    friend constexpr uint256 operator&(const uint256 &a, const uint256 &b)
+    {
+#if defined(__AVX2__)
+        if !consteval
+        {
+            return store(_mm256_and_si256(a.load(), b.load()));
+        }
+#endif
+        return wordwise(a, b, [](uint64_t x, uint64_t y) { return x & y; });
+    }
+
+    friend constexpr uint256 operator|(const uint256 &a, const uint256 &b)
+    {
+#if defined(__AVX2__)
+        if !consteval
+        {
+            return store(_mm256_or_si256(a.load(), b.load()));
+        }
+#endif
+        return wordwise(a, b, [](uint64_t x, uint64_t y) { return x | y; });
+    }
+
+    friend constexpr uint256 operator^(const uint256 &a, const uint256 &b)
+    {
+#if defined(__AVX2__)
+        if !consteval
+        {
+            return store(_mm256_xor_si256(a.load(), b.load()));
+        }
+#endif
+        return wordwise(a, b, [](uint64_t x, uint64_t y) { return x ^ y; });
+    }
+
+    friend constexpr uint256 operator~(const uint256 &a)
+    {
+        return a ^ from_words(~uint64_t(0), ~uint64_t(0), ~uint64_t(0), ~uint64_t(0));
+    }
+
+    friend constexpr uint256 operator<<(const uint256 &a, size_t amount)
+    {
+        uint256 result;
+        if (amount >= 256)
+            return result;
+
+        const size_t words = amount / 64, bits = amount % 64;
+        for (size_t i = words; i < 4; ++i)
+        {
+            uint64_t value = a.m_words[i - words] << bits;
+            if (bits > 0 && i > words)
+                value |= a.m_words[i - words - 1] >> (64 - bits);
+            result.m_words[i] = value;
+        }
+        return result;
+    }
+
+    friend constexpr uint256 operator>>(const uint256 &a, size_t amount)
+    {
+        uint256 result;
+        if (amount >= 256)
+            return result;
+
+        const size_t words = amount / 64, bits = amount % 64;
+        for (size_t i = 0; i + words < 4; ++i)
+        {
+            uint64_t value = a.m_words[i + words] >> bits;
+            if (bits > 0 && i + words + 1 < 4)
+                value |= a.m_words[i + words + 1] << (64 - bits);
+            result.m_words[i] = value;
+        }
+        return result;
+    }
+
+    friend constexpr uint256 operator+(const uint256 &a, const uint256 &b)
+    {
+        uint256 result;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const uint64_t sum = a.m_words[i] + b.m_words[i];
+            result.m_words[i] = sum + carry;
+            carry = (sum < a.m_words[i]) | (result.m_words[i] < sum);
+        }
+        return result;
+    }
+
+    friend constexpr uint256 operator-(const uint256 &a, const uint256 &b)
+    {
+        uint256 result;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const uint64_t difference = a.m_words[i] - b.m_words[i];
+            result.m_words[i] = difference - borrow;
+            borrow = (a.m_words[i] < b.m_words[i]) | (difference < borrow);
+        }
+        return result;
+    }
+
+    friend constexpr uint256 operator*(const uint256 &a, const uint256 &b)
+    {
+        uint256 result;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            unsigned __int128 carry = 0;
+            for (size_t j = 0; i + j < 4; ++j)
+            {
+                const unsigned __int128 product =
+                    static_cast<unsigned __int128>(a.m_words[i]) * b.m_words[j] + result.m_words[i + j] + carry;
+                result.m_words[i + j] = static_cast<uint64_t>(product);
+                carry = product >> 64;
+            }
+        }
+        return result;
+    }
+
+    /// @return Quotient and remainder of a division by a 64-bit divisor.
+    [[nodiscard]] constexpr std::pair<uint256, uint64_t> divide(uint64_t divisor) const
+    {
+        uint256 quotient;
+        unsigned __int128 remainder = 0;
+        for (size_t i = 4; i > 0; --i)
+        {
+            const unsigned __int128 dividend = (remainder << 64) | m_words[i - 1];
+            quotient.m_words[i - 1] = static_cast<uint64_t>(dividend / divisor);
+            remainder = dividend % divisor;
+        }
+        return { quotient, static_cast<uint64_t>(remainder) };
+    }
+
+    friend constexpr uint256 operator/(const uint256 &a, uint64_t divisor)
+    {
+        return a.divide(divisor).first;
+    }
+
+    friend constexpr uint64_t operator%(const uint256 &a, uint64_t divisor)
+    {
+        return a.divide(divisor).second;
+    }
+
+    constexpr uint256& operator&=(const uint256 &other) { return *this = *this & other; }
+    constexpr uint256& operator|=(const uint256 &other) { return *this = *this | other; }
+    constexpr uint256& operator^=(const uint256 &other) { return *this = *this ^ other; }
+    constexpr uint256& operator+=(const uint256 &other) { return *this = *this + other; }
+    constexpr uint256& operator-=(const uint256 &other) { return *this = *this - other; }
+    constexpr uint256& operator<<=(size_t amount) { return *this = *this << amount; }
+    constexpr uint256& operator>>=(size_t amount) { return *this = *this >> amount; }
+
+    constexpr uint256& operator++()
+    {
+        return *this += 1;
+    }
+
+    constexpr uint256 operator++(int)
+    {
+        const uint256 previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    friend constexpr bool operator==(const uint256 &a, const uint256 &b) = default;
+
+    friend constexpr std::strong_ordering operator<=>(const uint256 &a, const uint256 &b)
+    {
+        for (size_t i = 4; i > 0; --i)
+        {
+            if (a.m_words[i - 1] != b.m_words[i - 1])
+                return a.m_words[i - 1] <=> b.m_words[i - 1];
+        }
+        return std::strong_ordering::equal;
+    }
+
+    template<class H>
+    friend H AbslHashValue(H hash, const uint256 &value)
+    {
+        return H::combine(std::move(hash), value.m_words[0], value.m_words[1], value.m_words[2], value.m_words[3]);
+    }
+
+    /// @brief Write the value in decimal like the absl::uint128 stream operator does.
+    friend std::ostream& operator<<(std::ostream &os, const uint256 &value)
+    {
+        // Peel off 19 decimal digits at a time, the largest power of ten that fits a word.
+        constexpr uint64_t Chunk = 10'000'000'000'000'000'000ull;
+
+        std::string digits;
+        uint256 rest = value;
+        do
+        {
+            auto [quotient, remainder] = rest.divide(Chunk);
+            std::string chunk = std::to_string(remainder);
+            if (quotient)
+                chunk.insert(0, 19 - chunk.size(), '0');
+            digits.insert(0, chunk);
+            rest = quotient;
+        } while (rest);
+
+        return os << digits;
+    }
+};
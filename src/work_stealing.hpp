@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include <instrumentation.hpp>
+
+/// @brief Runs a range of independent tasks on a fixed number of threads.
+/// Every worker owns a deque that is seeded with a contiguous block of tasks. Workers pop
+/// from the front of their own deque and steal from the back of the others once it runs dry.
+/// The calling thread is worker 0, the other workers are started by the first run that needs
+/// them and wait for the next run until the scheduler is destroyed, so short runs issued in a
+/// loop do not pay for creating and joining threads.
+class WorkStealingScheduler
+{
+
+private:
+
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    size_t m_thread_count;
+
+    std::atomic<size_t> m_steals;
+
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_pool_mutex;
+
+    std::condition_variable m_wake;
+
+    std::condition_variable m_done;
+
+    /// @brief Counts the runs handed to the pool, a worker joins every run it has not seen yet.
+    uint64_t m_generation = 0;
+
+    bool m_stopping = false;
+
+    /// @brief Work loop of the current run, called with the worker index.
+    const std::function<void(size_t)> *m_job = nullptr;
+
+    size_t m_active_workers = 0;
+
+    /// @brief Pool workers that have not finished the current run yet.
+    size_t m_pending = 0;
+
+    [[nodiscard]] static std::optional<size_t> pop_front(TaskQueue &queue)
+    {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+            return std::nullopt;
+
+        const size_t task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return task;
+    }
+
+    [[nodiscard]] static std::optional<size_t> pop_back(TaskQueue &queue)
+    {
+        std::lock_guard lock(queue.mutex);
+        if (queue.tasks.empty())
+            return std::nullopt;
+
+        const size_t task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return task;
+    }
+
+    void pool_loop(size_t worker)
+    {
+        uint64_t seen = 0;
+        std::unique_lock lock(m_pool_mutex);
+        for (;;)
+        {
+            m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+            if (m_stopping)
+                return;
+
+            seen = m_generation;
+            if (worker >= m_active_workers)
+                continue;
+
+            const auto &job = *m_job;
+            lock.unlock();
+            job(worker);
+            lock.lock();
+
+            if (0 == --m_pending)
+                m_done.notify_one();
+        }
+    }
+
+public:
+
+    /// @param thread_count Number of worker threads, zero picks the hardware concurrency.
+    explicit WorkStealingScheduler(size_t thread_count = 0)
+    : m_thread_count(thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency()))
+    , m_steals(0)
+    {
+
+    }
+
+    WorkStealingScheduler(const WorkStealingScheduler&) = delete;
+    WorkStealingScheduler& operator=(const WorkStealingScheduler&) = delete;
+
+    ~WorkStealingScheduler()
+    {
+        {
+            std::lock_guard lock(m_pool_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &thread : m_threads)
+            thread.join();
+    }
+
+    [[nodiscard]] size_t thread_count() const
+    {
+        return m_thread_count;
+    }
+
+    /// @brief Number of tasks that were executed by a worker other than their owner during the last run.
+    [[nodiscard]] size_t steals() const
+    {
+        return m_steals.load();
+    }
+
+    /// @brief Execute tasks [0, task_count) and return once all of them are done. Runs of one
+    /// scheduler must not overlap. When a task throws the remaining tasks are skipped and the
+    /// first exception is rethrown here.
+    /// @param task_count Number of tasks.
+    /// @param task Callable invoked as task(worker_index, task_index).
+    template<class Task>
+    void run(size_t task_count, Task &&task)
+    {
+        m_steals = 0;
+
+        const size_t worker_count = std::min(m_thread_count, std::max<size_t>(task_count, 1));
+        std::vector<std::unique_ptr<TaskQueue>> queues;
+        for (size_t worker = 0; worker < worker_count; ++worker)
+        {
+            queues.push_back(std::make_unique<TaskQueue>());
+            const size_t begin = task_count * worker / worker_count;
+            const size_t end = task_count * (worker + 1) / worker_count;
+            for (size_t task_index = begin; task_index < end; ++task_index)
+                queues.back()->tasks.push_back(task_index);
+        }
+
+        std::atomic<bool> failed = false;
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        const std::function<void(size_t)> work = [&](size_t worker)
+        {
+            const instrumentation::Span span("tasks", "scheduler");
+            while (!failed.load(std::memory_order_relaxed))
+            {
+                std::optional<size_t> task_index = pop_front(*queues[worker]);
+
+                for (size_t offset = 1; !task_index && offset < worker_count; ++offset)
+                {
+                    task_index = pop_back(*queues[(worker + offset) % worker_count]);
+                    if (task_index)
+                        ++m_steals;
+                }
+
+                // Tasks never spawn new tasks, so every queue being empty means we are done.
+                if (!task_index)
+                    return;
+
+                try
+                {
+                    task(worker, *task_index);
+                }
+                catch (...)
+                {
+                    std::lock_guard lock(error_mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    failed = true;
+                }
+            }
+        };
+
+        if (worker_count > 1)
+        {
+            {
+                std::lock_guard lock(m_pool_mutex);
+                for (size_t worker = m_threads.size() + 1; worker < m_thread_count; ++worker)
+                    m_threads.emplace_back(&WorkStealingScheduler::pool_loop, this, worker);
+
+                m_job = &work;
+                m_active_workers = worker_count;
+                m_pending = worker_count - 1;
+                ++m_generation;
+            }
+            m_wake.notify_all();
+
+            work(0);
+
+            std::unique_lock lock(m_pool_mutex);
+            m_done.wait(lock, [&] { return 0 == m_pending; });
+            m_job = nullptr;
+        }
+        else
+        {
+            work(0);
+        }
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+};
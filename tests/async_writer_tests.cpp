@@ -0,0 +1,171 @@
+#include <assert.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <async_writer.hpp>
+
+using namespace std;
+
+template<class T>
+string formatted(const T &value)
+{
+    OutputBuffer buffer;
+    buffer.append(value);
+    return string(buffer.view());
+}
+
+template<class T>
+string streamed(const T &value)
+{
+    ostringstream os;
+    os << value;
+    return os.str();
+}
+
+string read_file(const filesystem::path &path)
+{
+    ifstream is(path, ios::binary);
+    return string((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+}
+
+int main()
+{
+    // Wide integers come out like their stream operators write them, zeros inside a 19 digit chunk included.
+    constexpr uint64_t Chunk = 10'000'000'000'000'000'000ull;
+    const absl::uint128 max128 = absl::Uint128Max();
+    for (const absl::uint128 value : { absl::uint128(0), absl::uint128(~uint64_t(0)), absl::uint128(~uint64_t(0)) + 1,
+        absl::uint128(Chunk), absl::uint128(Chunk) * Chunk, absl::uint128(Chunk) * Chunk + 7, max128 })
+    {
+        assert(formatted(value) == streamed(value));
+    }
+    assert("340282366920938463463374607431768211455" == formatted(max128));
+
+    const uint256 max256 = ~uint256(0);
+    for (const uint256 &value : { uint256(0), uint256(Chunk), uint256(Chunk) * Chunk * Chunk + 1, uint256(max128) + 1, max256 })
+        assert(formatted(value) == streamed(value));
+    assert("115792089237316195423570985008687907853269984665640564039457584007913129639935" == formatted(max256));
+
+    mt19937_64 random(5);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto value = uint256::from_words(random(), random(), random(), random()) >> (random() % 256);
+        assert(formatted(value) == streamed(value));
+        const absl::uint128 narrow = absl::MakeUint128(random(), random()) >> (random() % 128);
+        assert(formatted(narrow) == streamed(narrow));
+    }
+
+    OutputBuffer buffer;
+    buffer.append("a");
+    buffer.append(' ');
+    buffer.append(-12);
+    buffer.append(uint8_t(200));
+    assert("a -12200" == buffer.view());
+
+    const auto path = filesystem::temp_directory_path() / "golc-async-writer-tests.txt";
+
+    // Items are written in push order, even through a tiny queue and buffer.
+    {
+        AsyncWriter<int> writer(path, [](const int &item, OutputBuffer &buffer)
+        {
+            buffer.append(item);
+            buffer.append('\n');
+        }, 2, 16);
+
+        string expected;
+        for (int i = 0; i < 10000; ++i)
+        {
+            writer.push(i);
+            expected += to_string(i) + '\n';
+        }
+
+        const auto stats = writer.close();
+        assert(10000 == stats.items);
+        assert(expected.size() == stats.bytes);
+        assert(stats.flushes > 1 && stats.max_queue_depth <= 2);
+        assert(read_file(path) == expected);
+
+        // A closed writer takes no more items.
+        bool thrown = false;
+        try
+        {
+            writer.push(0);
+        }
+        catch (const runtime_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Once the formatter fails, push throws its error instead of dropping the items, and so does close.
+    {
+        AsyncWriter<int> writer(path, [](const int &item, OutputBuffer&)
+        {
+            if (item >= 100)
+                throw runtime_error("format failed");
+        }, 1);
+
+        bool thrown = false;
+        for (int i = 0; !thrown && i < 1'000'000; ++i)
+        {
+            try
+            {
+                writer.push(i);
+            }
+            catch (const runtime_error &e)
+            {
+                assert(string("format failed") == e.what());
+                assert(i > 100);
+                thrown = true;
+            }
+        }
+        assert(thrown);
+
+        thrown = false;
+        try
+        {
+            (void)writer.close();
+        }
+        catch (const runtime_error &e)
+        {
+            assert(string("format failed") == e.what());
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    // Files that can not be created or written fail loudly.
+    bool thrown = false;
+    try
+    {
+        AsyncWriter<int> writer(path / "missing" / "file.txt", [](const int&, OutputBuffer&) {});
+    }
+    catch (const runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    if (filesystem::exists("/dev/full"))
+    {
+        AsyncWriter<int> writer("/dev/full", [](const int &item, OutputBuffer &buffer) { buffer.append(item); });
+        writer.push(1);
+
+        thrown = false;
+        try
+        {
+            (void)writer.close();
+        }
+        catch (const runtime_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    filesystem::remove(path);
+}
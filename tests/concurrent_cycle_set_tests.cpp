@@ -0,0 +1,88 @@
+#include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include <concurrent_cycle_set.hpp>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+int main()
+{
+    // Cycles of scattered 8x8 start states, most of them found many times over.
+    vector<Cycle<8>> found;
+    vector<Frame<8>> cycle_frames;
+    for (uint64_t state = 1; state < 1 << 13; ++state)
+    {
+        GameOfLife<8> game{ Frame<8>(state * 0x9e3779b97f4a7c15ull) };
+        found.push_back(game.find_cycle(cycle_frames));
+    }
+
+    vector<Cycle<8>> reference = found;
+    sort(reference.begin(), reference.end(), Cycle<8>::Less());
+    reference.erase(unique(reference.begin(), reference.end(), Cycle<8>::Equal()), reference.end());
+    assert(reference.size() > 50);
+
+    // Threads insert every cycle in their own order into few shards, so they keep contending and
+    // rehashing, while others look cycles up.
+    for (const size_t shard_count : { 1, 4, 64 })
+    {
+        ConcurrentCycleSet<8> set(shard_count);
+        constexpr size_t ThreadCount = 8;
+        vector<vector<pair<uint32_t, bool>>> results(ThreadCount);
+        atomic<size_t> lookups_failed = 0;
+
+        vector<thread> threads;
+        for (size_t t = 0; t < ThreadCount; ++t)
+        {
+            threads.emplace_back([&, t]
+            {
+                vector<size_t> order(found.size());
+                for (size_t i = 0; i < order.size(); ++i)
+                    order[i] = i;
+                shuffle(order.begin(), order.end(), mt19937(static_cast<unsigned>(t)));
+
+                results[t].resize(found.size());
+                for (const auto i : order)
+                {
+                    results[t][i] = set.insert(found[i]);
+                    if (!set.contains(found[i]))
+                        ++lookups_failed;
+                }
+            });
+        }
+        for (auto &thread : threads)
+            thread.join();
+
+        assert(0 == lookups_failed);
+        assert(set.size() == reference.size());
+
+        // Every thread got the same id for equal cycles and each cycle was inserted exactly once.
+        size_t inserted = 0;
+        for (size_t i = 0; i < found.size(); ++i)
+        {
+            for (size_t t = 0; t < ThreadCount; ++t)
+            {
+                assert(results[t][i].first == results[0][i].first);
+                assert(Cycle<8>::Equal()(set.cycle(results[t][i].first), found[i]));
+                inserted += results[t][i].second;
+            }
+            assert(set.find(found[i]) == results[0][i].first);
+        }
+        assert(inserted == reference.size());
+
+        // Final ids follow the sorted order, whatever the shards and the interleaving were.
+        const auto sorted = set.finalize();
+        assert(sorted.size() == reference.size());
+        for (size_t i = 0; i < sorted.size(); ++i)
+            assert(Cycle<8>::Equal()(sorted[i], reference[i]));
+        for (size_t i = 0; i < found.size(); ++i)
+            assert(Cycle<8>::Equal()(reference[set.final_id(results[0][i].first)], found[i]));
+
+        auto snapshot = set.snapshot();
+        sort(snapshot.begin(), snapshot.end(), Cycle<8>::Less());
+        assert(equal(snapshot.begin(), snapshot.end(), reference.begin(), reference.end(), Cycle<8>::Equal()));
+    }
+}
@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <stdexcept>
+#include <vector>
+#include <cycle_catalogue.hpp>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+int main()
+{
+    // Distinct cycles of the 6x6 board in discovery order, with repeats.
+    vector<Cycle<6>> found;
+    vector<Frame<6>> cycle_frames;
+    for (uint64_t state = 1; state < 1 << 14; state += 13)
+    {
+        GameOfLife<6> game{ Frame<6>(state * 0x9e3779b97f4a7c15ull & ((1ull << 36) - 1)) };
+        found.push_back(game.find_cycle(cycle_frames));
+    }
+
+    // A catalogue reserved for few cycles grows its index and keeps the ids of first insertion.
+    CycleCatalogue<6> catalogue(1);
+    vector<Cycle<6>> unique_cycles;
+    for (const auto &cycle : found)
+    {
+        const auto [id, inserted] = catalogue.insert(cycle);
+        if (inserted)
+        {
+            assert(id == unique_cycles.size());
+            unique_cycles.push_back(cycle);
+        }
+        else
+        {
+            assert(Cycle<6>::Equal()(unique_cycles[id], cycle));
+        }
+    }
+    assert(unique_cycles.size() > 16);
+    assert(catalogue.size() == unique_cycles.size());
+
+    size_t frame_count = 0;
+    for (uint32_t id = 0; id < catalogue.size(); ++id)
+    {
+        const auto &cycle = unique_cycles[id];
+        assert(catalogue.id(cycle) == id);
+        assert(catalogue.find(cycle.canonical()) == id);
+        assert(catalogue.period(id) == cycle.frames().size());
+        assert(Cycle<6>::Equal()(catalogue.cycle(id), cycle));
+        assert(std::equal(catalogue.frames(id).begin(), catalogue.frames(id).end(), cycle.frames().begin(), cycle.frames().end()));
+        frame_count += cycle.frames().size();
+    }
+    assert(catalogue.frame_count() == frame_count);
+
+    // Cycles that were never inserted are not found and have no id.
+    CycleCatalogue<6> partial;
+    for (size_t i = 0; i + 1 < unique_cycles.size(); ++i)
+        partial.insert(unique_cycles[i]);
+    assert(!partial.find(unique_cycles.back()));
+    bool thrown = false;
+    try
+    {
+        (void)partial.id(unique_cycles.back());
+    }
+    catch (const runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    const CycleCatalogue<6> empty;
+    assert(!empty.find(Cycle<6>()));
+
+    const auto memory = catalogue.memory_usage();
+    assert(memory.total_bytes == memory.arena_bytes + memory.record_bytes + memory.index_bytes);
+    assert(memory.arena_bytes >= frame_count * sizeof(Frame<6>));
+}
@@ -0,0 +1,142 @@
+#include <assert.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cycle_database.hpp>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+/// @brief Catalogue of the cycles reached from scattered states of the 6x6 board, with the empty board first.
+CycleCatalogue<6> sample_catalogue()
+{
+    CycleCatalogue<6> catalogue;
+    catalogue.insert(Cycle<6>());
+
+    vector<Frame<6>> cycle_frames;
+    for (uint64_t state = 1; state < 1 << 12; state += 11)
+    {
+        GameOfLife<6> game{ Frame<6>(state * 0x9e3779b97f4a7c15ull & ((1ull << 36) - 1)) };
+        catalogue.insert(game.find_cycle(cycle_frames));
+    }
+    return catalogue;
+}
+
+/// @brief Write a copy of a database with some of its bytes changed and check that opening it fails.
+void assert_rejected(const filesystem::path &path, const function<void(string&)> &corrupt)
+{
+    ifstream is(path, ios::binary);
+    string bytes((istreambuf_iterator<char>(is)), istreambuf_iterator<char>());
+    corrupt(bytes);
+
+    const auto corrupted = filesystem::temp_directory_path() / "golc-corrupted.db";
+    ofstream(corrupted, ios::binary | ios::trunc).write(bytes.data(), static_cast<streamsize>(bytes.size()));
+
+    bool thrown = false;
+    try
+    {
+        const CycleDatabase<6> database(corrupted);
+    }
+    catch (const runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    filesystem::remove(corrupted);
+}
+
+/// @brief Overwrite a header field.
+template<class T>
+void set_field(string &bytes, size_t offset, T value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+int main()
+{
+    const auto catalogue = sample_catalogue();
+    const auto path = filesystem::temp_directory_path() / "golc-cycle-database-tests.db";
+
+    // A written database reads back with the ids, frames and periods of the catalogue.
+    write_cycle_database(path, catalogue);
+    assert(!filesystem::exists(path.string() + ".tmp"));
+    {
+        const CycleDatabase<6> database(path);
+        assert(6 == cycle_database::board_size(path));
+        assert(database.size() == catalogue.size());
+        assert(database.frame_count() == catalogue.frame_count());
+
+        for (uint32_t id = 0; id < catalogue.size(); ++id)
+        {
+            assert(database.period(id) == catalogue.period(id));
+            assert(std::ranges::equal(database.frames(id), catalogue.frames(id)));
+            assert(database.find(catalogue.cycle(id)) == id);
+            assert(Cycle<6>::Equal()(database.cycle(id), catalogue.cycle(id)));
+        }
+
+        // The canonical index is sorted and every period lists exactly its cycles.
+        for (size_t position = 1; position < database.size(); ++position)
+            assert(database.frames(database.canonical_id(position - 1))[0] < database.frames(database.canonical_id(position))[0]);
+
+        size_t listed = 0;
+        for (const auto period : database.periods())
+        {
+            const auto ids = database.ids_with_period(period);
+            assert(!ids.empty());
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                assert(database.period(ids[i]) == period);
+                assert(0 == i || ids[i - 1] < ids[i]);
+            }
+            listed += ids.size();
+        }
+        assert(listed == database.size());
+
+        // A cycle that is not stored is not found.
+        assert(!database.find(Frame<6>(~uint64_t(0) >> 28)));
+    }
+
+    // Writing again replaces the file in place of the old one.
+    write_cycle_database(path, CycleCatalogue<6>());
+    assert(0 == CycleDatabase<6>(path).size());
+    write_cycle_database(path, catalogue);
+
+    // Damaged files are refused instead of being read out of bounds.
+    using cycle_database::Header;
+    using cycle_database::Record;
+    const auto header_field = [](auto Header::*field)
+    {
+        Header header{};
+        return static_cast<size_t>(reinterpret_cast<const char*>(&(header.*field)) - reinterpret_cast<const char*>(&header));
+    };
+
+    assert_rejected(path, [](string &bytes) { bytes[0] = 'X'; });
+    assert_rejected(path, [&](string &bytes) { set_field<uint32_t>(bytes, header_field(&Header::version), 99); });
+    assert_rejected(path, [](string &bytes) { bytes.resize(bytes.size() - 1); });
+    assert_rejected(path, [](string &bytes) { bytes.resize(sizeof(Header) / 2); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, header_field(&Header::frames_offset), 8); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, header_field(&Header::records_offset), 4 + cycle_database::SectionAlignment); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, header_field(&Header::cycle_count), uint64_t(1) << 40); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, header_field(&Header::frame_count), ~uint64_t(0) / 2); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, header_field(&Header::period_index_offset), ~uint64_t(0) - 63); });
+
+    // Records with frames past the frames section, an empty cycle and an index entry that is no cycle.
+    const auto records_offset = cycle_database::align(sizeof(Header));
+    const auto last_record = records_offset + (catalogue.size() - 1) * sizeof(Record);
+    assert_rejected(path, [&](string &bytes) { set_field<uint64_t>(bytes, last_record + offsetof(Record, offset), catalogue.frame_count()); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint32_t>(bytes, last_record + offsetof(Record, period), 2 + catalogue.period(catalogue.size() - 1)); });
+    assert_rejected(path, [&](string &bytes) { set_field<uint32_t>(bytes, records_offset + offsetof(Record, period), 0); });
+    assert_rejected(path, [&](string &bytes)
+    {
+        Header header;
+        memcpy(&header, bytes.data(), sizeof(header));
+        set_field<uint32_t>(bytes, header.canonical_index_offset, static_cast<uint32_t>(catalogue.size()));
+    });
+
+    filesystem::remove(path);
+}
@@ -0,0 +1,99 @@
+#include <assert.h>
+#include <sstream>
+#include <vector>
+#include <cycle_memo.hpp>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+/// @brief Scatter small counters over the whole 6x6 board.
+uint64_t scattered(uint64_t state)
+{
+    return state * 0x9e3779b97f4a7c15ull & ((1ull << 36) - 1);
+}
+
+/// @brief Fill a memo of 8 slots, the smallest one, with 9 frames.
+CycleMemo<5> overfilled(MemoEviction eviction)
+{
+    CycleMemo<5> memo(0, eviction);
+    assert(8 == memo.capacity());
+
+    memo.add_cycle(Cycle<5>());
+    for (uint64_t state = 1; state <= 9; ++state)
+        memo.insert(Frame<5>(state), 0);
+    return memo;
+}
+
+int main()
+{
+    // Keep drops the frame that does not fit.
+    {
+        const auto memo = overfilled(MemoEviction::Keep);
+        assert(8 == memo.size());
+        for (uint64_t state = 1; state <= 8; ++state)
+            assert(memo.find(Frame<5>(state)));
+        assert(!memo.find(Frame<5>(9)));
+        assert(0 == memo.statistics().evictions);
+    }
+
+    // Overwrite replaces the entry at the home slot of the new frame.
+    {
+        const auto memo = overfilled(MemoEviction::Overwrite);
+        assert(8 == memo.size());
+        assert(memo.find(Frame<5>(9)));
+        assert(1 == memo.statistics().evictions);
+        size_t remaining = 0;
+        for (uint64_t state = 1; state <= 8; ++state)
+            remaining += memo.find(Frame<5>(state)).has_value();
+        assert(7 == remaining);
+    }
+
+    // Flush forgets every frame but keeps the cycles.
+    {
+        const auto memo = overfilled(MemoEviction::Flush);
+        assert(1 == memo.size());
+        assert(1 == memo.statistics().flushes);
+        assert(memo.find(Frame<5>(9)));
+        assert(!memo.find(Frame<5>(1)));
+        assert(1 == memo.cycles().size());
+    }
+
+    // Every policy still gives the cycle Brent's detector finds, however small the memo.
+    for (const auto eviction : { MemoEviction::Keep, MemoEviction::Overwrite, MemoEviction::Flush })
+    {
+        CycleMemo<6> memo(0, eviction);
+        vector<Frame<6>> trajectory, cycle_frames;
+        for (uint64_t state = 1; state < 4096; state += 29)
+        {
+            const Frame<6> frame(scattered(state));
+            GameOfLife<6> memoized(frame), brent(frame);
+            assert(Cycle<6>::Equal()(memo.cycle(memoized.find_cycle(memo, trajectory)), brent.find_cycle(cycle_frames)));
+            assert(trajectory.empty());
+        }
+    }
+
+    // A saved memo loads into a table of another size with the same cycles and answers.
+    {
+        CycleMemo<6> memo(1 << 12);
+        vector<Frame<6>> trajectory;
+        vector<uint64_t> states;
+        for (uint64_t state = 1; state < 2048; state += 41)
+        {
+            states.push_back(scattered(state));
+            GameOfLife<6> game{ Frame<6>(states.back()) };
+            (void)game.find_cycle(memo, trajectory);
+        }
+
+        stringstream stream;
+        memo.save(stream);
+        CycleMemo<6> loaded(1 << 16);
+        loaded.load(stream);
+
+        assert(loaded.size() == memo.size());
+        assert(loaded.cycles().size() == memo.cycles().size());
+        for (size_t i = 0; i < memo.cycles().size(); ++i)
+            assert(Cycle<6>::Equal()(loaded.cycle(i), memo.cycle(i)));
+        for (const auto state : states)
+            assert(loaded.find(Frame<6>(state)) == memo.find(Frame<6>(state)));
+    }
+}
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <utility>
+#include <vector>
+#include <cycle.hpp>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+/// @brief Cycle reached from a start state of the 6x6 board.
+Cycle<6> cycle_from(uint64_t state)
+{
+    vector<Frame<6>> cycle_frames;
+    GameOfLife<6> game{ Frame<6>(state) };
+    return game.find_cycle(cycle_frames);
+}
+
+/// @brief Blinker in all its translations and rotations is the same cycle.
+void assert_normalized()
+{
+    const Frame<6> horizontal(0b111ull << 7);
+    const Frame<6> vertical((1ull << 2) | (1ull << 8) | (1ull << 14));
+    const Frame<6> elsewhere((1ull << 27) | (1ull << 33) | (1ull << 3));
+
+    const Cycle<6> a(vector<Frame<6>>{ horizontal, vertical });
+    const Cycle<6> b(vector<Frame<6>>{ vertical, horizontal });
+    const Cycle<6> c(vector<Frame<6>>{ elsewhere, GameOfLife<6>(elsewhere).next() });
+    assert(Cycle<6>::Equal()(a, b));
+    assert(Cycle<6>::Equal()(a, c));
+    assert(a.hash() == c.hash());
+    assert(GameOfLife<6>(horizontal).next() == vertical);
+    assert(2 == a.frames().size());
+    assert(a.frames()[0] < a.frames()[1]);
+    assert(a.canonical() == a.frames()[0]);
+    assert(a.contains(a.frames()[1]));
+}
+
+int main()
+{
+    assert_normalized();
+
+    // Default cycle is the empty board.
+    const Cycle<6> empty;
+    assert(1 == empty.frames().size());
+    assert(Frame<6>(0) == empty.canonical());
+
+    // Long cycles spill to the heap, copies and moves keep frames and hash.
+    vector<Cycle<6>> cycles;
+    for (uint64_t state = 1; state < 4096 && cycles.size() < 64; state += 53)
+        cycles.push_back(cycle_from(state * 0x9e3779b97f4a7c15ull & ((1ull << 36) - 1)));
+
+    for (const auto &cycle : cycles)
+    {
+        Cycle<6> copy(cycle);
+        assert(Cycle<6>::Equal()(copy, cycle));
+
+        Cycle<6> moved(std::move(copy));
+        assert(Cycle<6>::Equal()(moved, cycle));
+        assert(copy.frames().empty());
+
+        Cycle<6> assigned;
+        assigned = moved;
+        assert(Cycle<6>::Equal()(assigned, cycle));
+        assigned = std::move(moved);
+        assert(Cycle<6>::Equal()(assigned, cycle));
+
+        // Assigning a cycle to itself keeps it.
+        Cycle<6> &alias = assigned;
+        assigned = alias;
+        assert(Cycle<6>::Equal()(assigned, cycle));
+        assigned = std::move(alias);
+        assert(Cycle<6>::Equal()(assigned, cycle));
+        assert(assigned.canonical() == cycle.canonical());
+    }
+
+    // A cycle read back from its normalized frames is the same cycle.
+    for (const auto &cycle : cycles)
+        assert(Cycle<6>::Equal()(Cycle<6>::from_normalized(cycle.frames()), cycle));
+
+    // Ordering is strict and equal cycles are not less than each other.
+    for (size_t i = 0; i + 1 < cycles.size(); ++i)
+    {
+        const bool less = Cycle<6>::Less()(cycles[i], cycles[i + 1]);
+        const bool greater = Cycle<6>::Less()(cycles[i + 1], cycles[i]);
+        assert(!(less && greater));
+        assert(less || greater || Cycle<6>::Equal()(cycles[i], cycles[i + 1]));
+    }
+}
@@ -0,0 +1,133 @@
+#include <assert.h>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+#include <enumeration.hpp>
+
+using namespace std;
+
+template<size_t N>
+using BasinWeights = unordered_map<Cycle<N>, uint64_t, typename Cycle<N>::Hash, typename Cycle<N>::Equal>;
+
+/// @brief Basin of every cycle of the whole board, searched one state after the other.
+template<size_t N>
+BasinWeights<N> reference_basins()
+{
+    BasinWeights<N> basins;
+    vector<Frame<N>> cycle_frames;
+    for (uint64_t state = 0; state < uint64_t(Frame<N>::States); ++state)
+    {
+        GameOfLife<N> game{ Frame<N>(state) };
+        ++basins[game.find_cycle(cycle_frames)];
+    }
+    return basins;
+}
+
+template<size_t N>
+void assert_matches(const CycleSet<N> &cycles, const BasinWeights<N> &weights, const BasinWeights<N> &reference)
+{
+    assert(cycles.size() == reference.size());
+    assert(weights.size() == reference.size());
+    for (const auto &[cycle, weight] : reference)
+    {
+        assert(cycles.contains(cycle));
+        assert(weights.at(cycle) == weight);
+    }
+}
+
+int main()
+{
+    const auto reference = reference_basins<4>();
+
+    // Small chunks and memos give the workers plenty to steal and evict, the result stays the same.
+    for (const size_t thread_count : { 1, 2, 3, 8 })
+    {
+        EnumerationOptions options;
+        options.thread_count = thread_count;
+        options.chunk_size = 97;
+        options.memo_memory_limit = 1 << 10;
+        options.record_basin_weights = true;
+
+        ParallelEnumerator<4> enumerator(options);
+        assert(enumerator.thread_count() == thread_count);
+        const auto cycles = enumerator.enumerate(0, Frame<4>::States);
+        assert_matches<4>(cycles, enumerator.basin_weights(), reference);
+    }
+
+    // Simulating only the orbit representatives finds the same cycles, each representative weighs
+    // as much as its orbit.
+    for (const size_t thread_count : { 1, 4 })
+    {
+        EnumerationOptions options;
+        options.thread_count = thread_count;
+        options.chunk_size = 97;
+        options.symmetry_reduced = true;
+        options.record_basin_weights = true;
+
+        ParallelEnumerator<4> enumerator(options);
+        const auto cycles = enumerator.enumerate(0, Frame<4>::States);
+        assert_matches<4>(cycles, enumerator.basin_weights(), reference);
+    }
+
+    // A run stopped after some rounds and resumed from its checkpoint, possibly with another thread
+    // count and with or without the memos, returns what an uninterrupted run does.
+    uintmax_t checkpoint_sizes[2] = {};
+    for (const bool checkpoint_memos : { false, true })
+    {
+        const auto path = filesystem::temp_directory_path() / "golc-enumeration-tests.checkpoint";
+        filesystem::remove(path);
+
+        EnumerationOptions options;
+        options.thread_count = 3;
+        options.chunk_size = 256;
+        options.symmetry_reduced = true;
+        options.record_basin_weights = true;
+        options.checkpoint_path = path;
+        options.checkpoint_chunks = 16;
+        options.checkpoint_memos = checkpoint_memos;
+        options.resume = true;
+        options.round_limit = 1;
+
+        ParallelEnumerator<4> stopped(options);
+        const auto partial = stopped.enumerate(0, Frame<4>::States);
+        assert(partial.size() < reference.size());
+
+        checkpoint_sizes[checkpoint_memos] = filesystem::file_size(path);
+        ParallelEnumerator<4> resumed_once(options);
+        (void)resumed_once.enumerate(0, Frame<4>::States);
+
+        options.thread_count = 2;
+        options.round_limit = 0;
+        ParallelEnumerator<4> resumed(options);
+        const auto cycles = resumed.enumerate(0, Frame<4>::States);
+        assert_matches<4>(cycles, resumed.basin_weights(), reference);
+
+        // Resuming a finished run only reads the checkpoint.
+        ParallelEnumerator<4> finished(options);
+        assert_matches<4>(finished.enumerate(0, Frame<4>::States), finished.basin_weights(), reference);
+
+        // A checkpoint of another range is refused.
+        bool thrown = false;
+        try
+        {
+            ParallelEnumerator<4> other(options);
+            (void)other.enumerate(0, Frame<4>::States / 2);
+        }
+        catch (const runtime_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+
+        filesystem::remove(path);
+    }
+
+    // Memos are only saved on request.
+    assert(checkpoint_sizes[0] < checkpoint_sizes[1]);
+
+    // An empty range has no cycles.
+    {
+        ParallelEnumerator<4> enumerator;
+        assert(enumerator.enumerate(100, 100).empty());
+    }
+}
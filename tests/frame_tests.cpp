@@ -1,10 +1,241 @@
 #include <assert.h>
+#include <utility>
 #include <frame.hpp>
 
 using namespace std;
 
+/// @brief Cell of the source frame that lands on (row, col) when it is translated and then transformed,
+/// spelled out cell by cell so that it shares nothing with the row engine.
+template<size_t N>
+pair<size_t, size_t> source_cell(size_t row, size_t col, const Transform &transform)
+{
+    constexpr size_t Last = N - 1;
+    size_t r = row, c = col;
+    switch (transform.index)
+    {
+        case 1: c = Last - col; break;
+        case 2: r = Last - col; c = Last - row; break;
+        case 3: r = Last - col; c = row; break;
+        case 4: r = Last - row; c = Last - col; break;
+        case 5: r = Last - row; break;
+        case 6: r = col; c = row; break;
+        case 7: r = col; c = Last - row; break;
+        default: break;
+    }
+    return { (r + transform.row_offset) % N, (c + transform.col_offset) % N };
+}
+
+template<size_t N>
+Frame<N> reference_image(const Frame<N> &frame, const Transform &transform)
+{
+    Frame<N> image;
+    for (size_t row = 0; row < N; ++row)
+    {
+        for (size_t col = 0; col < N; ++col)
+        {
+            const auto [source_row, source_col] = source_cell<N>(row, col, transform);
+            image.set(row, col, frame.get(source_row, source_col));
+        }
+    }
+    return image;
+}
+
+/// @brief Smallest image over every translation and transform, ties keep the first one met in
+/// row offset, column offset and transform order.
+template<size_t N>
+Frame<N> reference_normalized(const Frame<N> &frame, Transform &min_transform)
+{
+    min_transform = Transform();
+    Frame<N> min_frame = frame;
+    for (size_t row_offset = 0; row_offset < N; ++row_offset)
+    {
+        for (size_t col_offset = 0; col_offset < N; ++col_offset)
+        {
+            for (size_t index = 0; index < 8; ++index)
+            {
+                const Transform transform(row_offset, col_offset, index);
+                const auto image = reference_image(frame, transform);
+                if (image < min_frame)
+                {
+                    min_frame = image;
+                    min_transform = transform;
+                }
+            }
+        }
+    }
+    return min_frame;
+}
+
+template<size_t N>
+typename Frame<N>::State seeded_state(uint64_t seed)
+{
+    using State = typename Frame<N>::State;
+    State state = 0;
+    for (size_t bit = 0; bit < Frame<N>::CellCount; ++bit)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        if (seed >> 63)
+            state = state | (State(1) << bit);
+    }
+    return state;
+}
+
+template<size_t N>
+void assert_normalized_matches_reference(typename Frame<N>::State state)
+{
+    const Frame<N> frame(state & Frame<N>::BoardMask);
+    Transform fast, reference, library;
+    const auto normalized = frame.normalized(fast);
+    assert(normalized == reference_normalized(frame, reference));
+    assert(fast.row_offset == reference.row_offset);
+    assert(fast.col_offset == reference.col_offset);
+    assert(fast.index == reference.index);
+    assert(reference_image(frame, fast) == normalized);
+
+    assert(frame.normalized_reference(library) == normalized);
+    assert(library.row_offset == fast.row_offset && library.col_offset == fast.col_offset && library.index == fast.index);
+}
+
+/// @brief Translations, transforms and single cells of the row engine land where the per-cell reference puts them.
+template<size_t N>
+void assert_transforms_match_reference(typename Frame<N>::State state)
+{
+    const Frame<N> frame(state & Frame<N>::BoardMask);
+    [&]<size_t... Index>(index_sequence<Index...>)
+    {
+        (assert(frame.template transformed<Index>() == reference_image(frame, Transform(0, 0, Index))), ...);
+    }(make_index_sequence<8>());
+
+    for (size_t index = 0; index < 8; ++index)
+    {
+        for (const size_t row_offset : { size_t(0), size_t(1), N / 2, N - 1 })
+        {
+            for (const size_t col_offset : { size_t(0), size_t(2) % N, N - 1 })
+            {
+                const Transform transform(row_offset, col_offset, index);
+                assert(frame.translated(row_offset, col_offset).transformed(index) == reference_image(frame, transform));
+
+                for (size_t row = 0; row < N; row += 3)
+                {
+                    for (size_t col = 0; col < N; ++col)
+                    {
+                        const auto [source_row, source_col] = source_cell<N>(row, col, transform);
+                        assert(Frame<N>::transformed_cell(Frame<N>::to_index(source_row, source_col), transform) == Frame<N>::to_index(row, col));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<size_t N>
+void assert_seeded_boards_match_reference()
+{
+    assert_normalized_matches_reference<N>(0);
+    assert_normalized_matches_reference<N>(Frame<N>::BoardMask);
+    for (uint64_t seed = 1; seed <= 8; ++seed)
+    {
+        assert_transforms_match_reference<N>(seeded_state<N>(seed));
+        assert_normalized_matches_reference<N>(seeded_state<N>(seed));
+
+        // Sparse boards have many equal rows and images, which exercises the tie-break.
+        assert_normalized_matches_reference<N>(seeded_state<N>(seed) & seeded_state<N>(seed + 100) & seeded_state<N>(seed + 200));
+    }
+}
+
+/// @brief Walk every state of the board, the candidates never skip a canonical state and the orbits
+/// of the canonical states cover the board.
+template<size_t N>
+void assert_candidates_cover_canonical_states()
+{
+    using State = typename Frame<N>::State;
+    uint64_t covered = 0;
+    State next_canonical = Frame<N>::States;
+    for (State state = Frame<N>::States; state-- > 0;)
+    {
+        const size_t orbit_size = Frame<N>(state).canonical_orbit_size();
+        if (orbit_size > 0)
+            next_canonical = state;
+        covered += orbit_size;
+
+        State candidate = state;
+        const bool found = Frame<N>::next_canonical_candidate(candidate);
+        assert(found || next_canonical == Frame<N>::States);
+        if (found)
+            assert(state <= candidate && candidate <= next_canonical);
+    }
+    assert(covered == uint64_t(Frame<N>::States));
+}
+
+/// @brief Canonical frames of scattered boards are candidates, and so are the last states before them.
+template<size_t N>
+void assert_canonical_frames_are_candidates(uint64_t seed)
+{
+    using State = typename Frame<N>::State;
+    const State state = seeded_state<N>(seed);
+
+    Transform transform;
+    const auto canonical = Frame<N>(state).normalized(transform).get();
+    for (uint64_t distance = 0; distance < 64 && State(distance) <= canonical; ++distance)
+    {
+        State candidate = canonical - State(distance);
+        assert(Frame<N>::next_canonical_candidate(candidate));
+        assert(candidate <= canonical);
+        if (0 == distance)
+            assert(candidate == canonical);
+    }
+}
+
 int main()
 {
+    // Glider in the top left corner of a 5x5 torus.
+    Frame<5> glider;
+    glider.set(0, 1, true);
+    glider.set(1, 2, true);
+    glider.set(2, 0, true);
+    glider.set(2, 1, true);
+    glider.set(2, 2, true);
+
+    for (size_t row = 0; row < 5; ++row)
+    {
+        for (size_t col = 0; col < 5; ++col)
+        {
+            assert(glider.translated(1, 3).get(row, col) == glider.get((row + 1) % 5, (col + 3) % 5));
+            assert((glider.flipped<false, true>().get(row, col) == glider.get(row, 4 - col)));
+            assert((glider.flipped<true, false>().get(row, col) == glider.get(4 - row, col)));
+            assert(glider.transposed<false>().get(row, col) == glider.get(col, row));
+            assert(glider.transposed<true>().get(row, col) == glider.get(4 - col, 4 - row));
+            assert(glider.rotated<true>().get(row, col) == glider.get(4 - col, row));
+            assert(glider.rotated<false>().get(row, col) == glider.get(col, 4 - row));
+        }
+    }
+
+    assert_normalized_matches_reference<5>(glider.get());
+    assert_normalized_matches_reference<7>(~absl::uint128(0) / 5);
+    assert_normalized_matches_reference<11>(~absl::uint128(0) / 13);
+    assert_normalized_matches_reference<13>(~uint256(0) / 11);
+    assert_normalized_matches_reference<16>(uint256::from_words(0x9e3779b97f4a7c15ull, 0, 0x94d049bb133111ebull, 1));
+
+    for (uint64_t state = 0; state < uint64_t(Frame<4>::States); ++state)
+        assert_normalized_matches_reference<4>(state);
+
+    []<size_t... Offset>(index_sequence<Offset...>)
+    {
+        (assert_seeded_boards_match_reference<3 + Offset>(), ...);
+    }(make_index_sequence<14>());
+
+    assert_candidates_cover_canonical_states<3>();
+    assert_candidates_cover_canonical_states<4>();
+    for (uint64_t seed = 1; seed <= 20; ++seed)
+    {
+        assert_canonical_frames_are_candidates<5>(seed);
+        assert_canonical_frames_are_candidates<8>(seed);
+        assert_canonical_frames_are_candidates<11>(seed);
+        assert_canonical_frames_are_candidates<12>(seed);
+        assert_canonical_frames_are_candidates<16>(seed);
+    }
+
+
     // Transform t;
     // Frame<4> frame(0);
     // auto normalized_frame = frame.normalized(t);
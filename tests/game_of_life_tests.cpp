@@ -0,0 +1,49 @@
+#include <assert.h>
+#include <unordered_set>
+#include <game_of_life.hpp>
+
+using namespace std;
+
+template<size_t N>
+void assert_step_matches_reference(typename Frame<N>::State state)
+{
+    GameOfLife<N> game(Frame<N>(state & Frame<N>::BoardMask));
+    assert(game.next() == game.next_reference());
+}
+
+int main()
+{
+    // Blinker oscillates with period 2.
+    GameOfLife<5> blinker(Frame<5>(0b111ull << 5));
+    assert(blinker.next() == Frame<5>((1ull << 1) | (1ull << 6) | (1ull << 11)));
+    assert(GameOfLife<5>(blinker.next()).next() == blinker.frame());
+
+    // Neighbours wrap around both edges of the torus.
+    assert_step_matches_reference<5>((1ull << 0) | (1ull << 4) | (1ull << 20));
+    assert_step_matches_reference<8>(~absl::uint128(0) / 3);
+    assert_step_matches_reference<11>(~absl::uint128(0) / 7);
+    assert_step_matches_reference<13>(~uint256(0) / 7);
+    assert_step_matches_reference<16>(uint256::from_words(0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, 0x2545f4914f6cdd1dull));
+
+    // The symmetric sweep agrees with toggling every cell of every frame, the blinker is symmetric
+    // and its two phases are rotations of each other.
+    const Frame<5> blinker_frames[] = { blinker.frame(), blinker.next() };
+    const auto sweep = GameOfLife<5>::perturb_cycle(blinker_frames);
+    assert(sweep.simulated < 2 * Frame<5>::CellCount);
+    for (size_t frame_index = 0; frame_index < 2; ++frame_index)
+    {
+        const auto perturbed = GameOfLife<5>::perturb_all(blinker_frames[frame_index]);
+        for (size_t cell = 0; cell < Frame<5>::CellCount; ++cell)
+            assert(Cycle<5>::Equal()(perturbed[cell], sweep.cycles[sweep.outcomes[frame_index * Frame<5>::CellCount + cell]]));
+    }
+
+    // Brent's detector agrees with the visited-frame lookup.
+    vector<Frame<6>> cycle_frames;
+    unordered_map<Frame<6>, size_t, Frame<6>::Hash> visited_frames;
+    for (uint64_t state = 1; state < 4096; state += 37)
+    {
+        GameOfLife<6> brent(Frame<6>(state * 0x9e3779b97f4a7c15ull));
+        GameOfLife<6> lookup(brent.frame());
+        assert(Cycle<6>::Equal()(brent.find_cycle(cycle_frames), lookup.find_cycle(visited_frames, cycle_frames)));
+    }
+}
@@ -0,0 +1,43 @@
+#include <assert.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <instrumentation.hpp>
+
+using namespace std;
+
+int main()
+{
+    // Phases add up under their name whether or not the counters are compiled in.
+    for (int i = 0; i < 2; ++i)
+    {
+        const instrumentation::Phase phase("test-phase");
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    {
+        const instrumentation::Phase phase("other-phase");
+    }
+    instrumentation::count(instrumentation::Counter::Generations, 5);
+    instrumentation::record(instrumentation::Histogram::Period, 4);
+
+    ostringstream os;
+    instrumentation::write_report(os);
+    const string report = os.str();
+    assert(report.find("{ \"name\": \"test-phase\", \"calls\": 2, \"ms\": ") != string::npos);
+    assert(report.find("{ \"name\": \"other-phase\", \"calls\": 1, ") != string::npos);
+    assert(report.find("\"peak_resident_bytes\": ") != string::npos);
+
+    // Counters and histograms only count with GOLC_INSTRUMENTATION.
+    if constexpr (instrumentation::Enabled)
+    {
+        assert(report.find("\"instrumentation\": true") != string::npos);
+        assert(report.find("\"counters\": { \"generations\": 5,") != string::npos);
+        assert(report.find("\"period\": [0, 0, 0, 1]") != string::npos);
+    }
+    else
+    {
+        assert(report.find("\"instrumentation\": false") != string::npos);
+        assert(report.find("\"counters\": { \"generations\": 0,") != string::npos);
+        assert(report.find("\"period\": []") != string::npos);
+    }
+}
@@ -0,0 +1,108 @@
+#include <assert.h>
+#include <algorithm>
+#include <complex>
+#include <random>
+#include <vector>
+#include <markov_analysis.hpp>
+
+using namespace std;
+
+/// @brief Rate matrix of a random chain with a few transitions out of every state and one absorbing state.
+MarkovAnalysis::RateMatrix random_rates(Eigen::Index n, unsigned seed)
+{
+    mt19937 generator(seed);
+    uniform_int_distribution<Eigen::Index> target(0, n - 1);
+    uniform_real_distribution<double> rate(0.1, 3.0);
+
+    vector<Eigen::Triplet<double>> entries;
+    for (Eigen::Index row = 1; row < n; ++row)
+    {
+        double escape = 0;
+        for (int k = 0; k < 4; ++k)
+        {
+            const Eigen::Index column = target(generator);
+            if (column == row)
+                continue;
+            const double value = rate(generator);
+            entries.emplace_back(row, column, value);
+            escape += value;
+        }
+        entries.emplace_back(row, row, -escape);
+    }
+
+    MarkovAnalysis::RateMatrix rates(n, n);
+    rates.setFromTriplets(entries.begin(), entries.end());
+    return rates;
+}
+
+/// @brief Check the eigenvalues against a dense solver, a small Krylov subspace forces restarts.
+void assert_matches_dense(const MarkovAnalysis::RateMatrix &rates, size_t krylov_dimension)
+{
+    MarkovOptions options;
+    options.thread_count = 3;
+    options.eigenvalue_count = 6;
+    options.krylov_dimension = krylov_dimension;
+    const MarkovAnalysis analysis(rates, options);
+
+    const Eigen::EigenSolver<Eigen::MatrixXd> dense(Eigen::MatrixXd(rates), false);
+    vector<complex<double>> expected(dense.eigenvalues().begin(), dense.eigenvalues().end());
+    sort(expected.begin(), expected.end(), [](const auto &a, const auto &b) { return a.real() > b.real(); });
+
+    assert(analysis.eigenvalues().size() == 6);
+    assert(analysis.converged_count() == 6);
+    assert(krylov_dimension >= size_t(rates.rows()) || analysis.restarts() > 0);
+    for (size_t i = 0; i < analysis.eigenvalues().size(); ++i)
+    {
+        const auto eigenvalue = analysis.eigenvalues()[i];
+        assert(analysis.converged(i));
+        assert(analysis.eigenvalue_residuals()[i] < 1e-6);
+        assert(abs(eigenvalue.real() - expected[i].real()) < 1e-7);
+        assert(any_of(expected.begin(), expected.end(), [&](const auto &value) { return abs(value - eigenvalue) < 1e-7; }));
+    }
+    assert(abs(analysis.eigenvalues()[0]) < 1e-9);
+}
+
+int main()
+{
+    // Restarted and unrestarted runs find the leading eigenvalues of the dense solver.
+    for (const unsigned seed : { 1u, 2u, 3u })
+    {
+        const auto rates = random_rates(400, seed);
+        assert_matches_dense(rates, 24);
+        assert_matches_dense(rates, 400);
+    }
+
+    // A subspace that fills the whole space is invariant after as many steps as there are states.
+    assert_matches_dense(random_rates(12, 4), 64);
+
+    // The quasi-stationary distribution solves pi Q = -theta pi off the absorbing state.
+    {
+        const auto rates = random_rates(200, 5);
+        const MarkovAnalysis analysis(rates);
+        const Eigen::VectorXd &pi = analysis.stationary();
+        assert(abs(pi.sum() - 1) < 1e-12);
+        assert(0 == pi[0]);
+
+        Eigen::VectorXd flow = (pi.transpose() * rates).transpose();
+        flow[0] = 0;
+        const double theta = -flow.sum();
+        assert((flow + theta * pi).lpNorm<Eigen::Infinity>() < 1e-8);
+
+        const auto order = analysis.ranking();
+        for (size_t rank = 1; rank < order.size(); ++rank)
+            assert(pi[order[rank - 1]] >= pi[order[rank]]);
+        assert(analysis.decay_rate(0) == 0);
+    }
+
+    // Eigenvalues that run out of restarts are reported as such.
+    {
+        MarkovOptions options;
+        options.eigenvalue_count = 6;
+        options.krylov_dimension = 10;
+        options.max_restarts = 0;
+        options.eigenvalue_tolerance = 1e-15;
+        const MarkovAnalysis analysis(random_rates(400, 6), options);
+        assert(0 == analysis.restarts());
+        assert(analysis.converged_count() < 6);
+    }
+}
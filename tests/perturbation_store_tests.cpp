@@ -0,0 +1,117 @@
+#include <assert.h>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <enumeration.hpp>
+#include <perturbation_store.hpp>
+
+using namespace std;
+
+/// @brief Every cycle of the 4x4 board, perturbations never leave it.
+CycleCatalogue<4> full_catalogue()
+{
+    ParallelEnumerator<4> enumerator;
+    const auto cycles = enumerator.enumerate(0, Frame<4>::States);
+
+    vector<Cycle<4>> sorted_cycles(cycles.begin(), cycles.end());
+    sort(sorted_cycles.begin(), sorted_cycles.end(), Cycle<4>::Less());
+    CycleCatalogue<4> catalogue(sorted_cycles.size());
+    for (const auto &cycle : sorted_cycles)
+        catalogue.insert(cycle);
+    return catalogue;
+}
+
+void assert_same(const PerturbationStore<4> &a, const PerturbationStore<4> &b)
+{
+    assert(a.size() == b.size());
+    for (uint32_t id = 0; id < a.size(); ++id)
+    {
+        assert(a.period(id) == b.period(id));
+        assert(a.complete(id) == b.complete(id));
+        if (a.complete(id))
+            assert(std::ranges::equal(a.destinations(id), b.destinations(id)));
+    }
+}
+
+void assert_throws(const function<void()> &action)
+{
+    bool thrown = false;
+    try
+    {
+        action();
+    }
+    catch (const runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+int main()
+{
+    const auto catalogue = full_catalogue();
+    const auto store = PerturbationStore<4>::compute(catalogue, 3);
+    assert(store.matches(catalogue));
+
+    // Every outcome is the cycle reached by simulating the perturbed frame.
+    for (uint32_t id = 0; id < store.size(); ++id)
+    {
+        assert(store.complete(id));
+        assert(store.destinations(id).size() == catalogue.period(id) * Frame<4>::CellCount);
+        for (size_t frame_index = 0; frame_index < catalogue.period(id); ++frame_index)
+        {
+            const auto cycles = GameOfLife<4>::perturb_all(catalogue.frames(id)[frame_index]);
+            for (size_t cell = 0; cell < Frame<4>::CellCount; ++cell)
+            {
+                assert(store.destination(id, frame_index, cell) == catalogue.id(cycles[cell]));
+                assert(store.destinations(id, frame_index)[cell] == catalogue.id(cycles[cell]));
+            }
+        }
+    }
+    assert_same(store, PerturbationStore<4>::compute(catalogue, 1));
+
+    // A saved store loads back with the same periods, flags and outcomes.
+    const auto path = filesystem::temp_directory_path() / "golc-perturbation-store-tests.bin";
+    store.save(path);
+    const auto loaded = PerturbationStore<4>::load(path);
+    assert(loaded.matches(catalogue));
+    assert_same(store, loaded);
+
+    // So does a partial one, which only simulates its missing rows after loading.
+    vector<uint32_t> periods(catalogue.size());
+    for (uint32_t id = 0; id < catalogue.size(); ++id)
+        periods[id] = catalogue.period(id);
+    PerturbationStore<4> partial(periods);
+    for (uint32_t id = 0; id < partial.size(); id += 2)
+    {
+        std::ranges::copy(store.destinations(id), partial.row(id).begin());
+        partial.set_complete(id);
+    }
+    partial.save(path);
+    auto loaded_partial = PerturbationStore<4>::load(path);
+    assert_same(partial, loaded_partial);
+    loaded_partial.fill_missing(catalogue, 2);
+    assert_same(store, loaded_partial);
+
+    // Rows of a store over some of the cycles move to the catalogue ids.
+    vector<Cycle<4>> cycles;
+    for (uint32_t id = catalogue.size(); id-- > 0;)
+        cycles.push_back(catalogue.cycle(id));
+    CycleCatalogue<4> reversed;
+    for (const auto &cycle : cycles)
+        reversed.insert(cycle);
+    assert_same(store, PerturbationStore<4>::compute(reversed, 2).remapped(catalogue, cycles, 2));
+
+    // Truncated files and files of other boards are refused.
+    const auto size = filesystem::file_size(path);
+    filesystem::resize_file(path, size - 1);
+    assert_throws([&] { (void)PerturbationStore<4>::load(path); });
+    filesystem::resize_file(path, 40);
+    assert_throws([&] { (void)PerturbationStore<4>::load(path); });
+
+    store.save(path);
+    assert_throws([&] { (void)PerturbationStore<5>::load(path); });
+    filesystem::remove(path);
+}
@@ -0,0 +1,92 @@
+#include <assert.h>
+#include <vector>
+#include <sampling.hpp>
+
+using namespace std;
+
+template<size_t N>
+struct SamplingResult
+{
+    CycleSet<N> cycles;
+    vector<SamplingRound> rounds;
+};
+
+template<size_t N>
+SamplingResult<N> run(SamplingOptions options, size_t thread_count)
+{
+    options.thread_count = thread_count;
+    options.memo_memory_limit = 1 << 12;
+    ParallelSampler<N> sampler(options);
+    auto cycles = sampler.sample();
+    assert(sampler.samples_taken() <= options.max_samples);
+    return { std::move(cycles), sampler.rounds() };
+}
+
+/// @brief Every thread count finds the same cycles in the same rounds.
+template<size_t N>
+void assert_deterministic(const SamplingOptions &options)
+{
+    const auto reference = run<N>(options, 1);
+    assert(!reference.cycles.empty());
+
+    for (const size_t thread_count : { 2, 3, 8 })
+    {
+        const auto result = run<N>(options, thread_count);
+        assert(result.cycles.size() == reference.cycles.size());
+        for (const auto &cycle : reference.cycles)
+            assert(result.cycles.contains(cycle));
+
+        assert(result.rounds.size() == reference.rounds.size());
+        for (size_t i = 0; i < reference.rounds.size(); ++i)
+        {
+            assert(result.rounds[i].samples == reference.rounds[i].samples);
+            assert(result.rounds[i].new_cycles == reference.rounds[i].new_cycles);
+        }
+    }
+}
+
+int main()
+{
+    // Numbers of a stream only depend on the seed, the stream and their position.
+    {
+        CounterRandom a(7, 3), b(7, 3), c(7, 4), d(8, 3);
+        for (int i = 0; i < 100; ++i)
+        {
+            const auto value = a.next();
+            assert(value == b.next());
+            assert(value != c.next());
+            assert(value != d.next());
+        }
+        for (int i = 0; i < 1000; ++i)
+            assert(a.below(10) < 10);
+    }
+
+    // Tasks and rounds that do not divide the samples evenly, with and without early stopping.
+    for (const auto mode : { SamplingMode::Uniform, SamplingMode::Stratified, SamplingMode::Blocks })
+    {
+        SamplingOptions options;
+        options.mode = mode;
+        options.seed = 11;
+        options.max_samples = 5000;
+        options.task_size = 97;
+        options.round_tasks = 7;
+        options.block_length = 40;
+        assert_deterministic<8>(options);
+
+        // Stops after a few of the eight rounds.
+        options.min_new_cycles_per_million = 20000;
+        assert_deterministic<8>(options);
+        const auto rounds = run<8>(options, 1).rounds.size();
+        assert(1 < rounds && rounds < 8);
+    }
+
+    // Boards past 128 cells draw their states from two numbers.
+    {
+        SamplingOptions options;
+        options.mode = SamplingMode::Stratified;
+        options.max_samples = 300;
+        options.task_size = 16;
+        options.round_tasks = 4;
+        assert_deterministic<12>(options);
+    }
+}
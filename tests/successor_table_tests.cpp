@@ -0,0 +1,55 @@
+#include <assert.h>
+#include <numeric>
+#include <enumeration.hpp>
+#include <successor_table.hpp>
+
+using namespace std;
+
+template<size_t N>
+void assert_matches_enumeration()
+{
+    const SuccessorTable<N> table(2);
+
+    EnumerationOptions options;
+    options.thread_count = 2;
+    options.symmetry_reduced = true;
+    options.record_basin_weights = true;
+    ParallelEnumerator<N> enumerator(options);
+    const auto cycles = enumerator.enumerate(0, Frame<N>::States);
+
+    // Same cycles with the same basins.
+    assert(table.cycles().size() == cycles.size());
+    for (size_t i = 0; i < table.cycles().size(); ++i)
+    {
+        assert(cycles.contains(table.cycles()[i]));
+        assert(enumerator.basin_weights().at(table.cycles()[i]) == table.basin_sizes()[i]);
+    }
+    assert(SuccessorTable<N>::StateCount == accumulate(table.basin_sizes().begin(), table.basin_sizes().end(), uint64_t(0)));
+
+    // The empty board sorts first and is its own cycle.
+    assert(typename Cycle<N>::Equal()(table.cycles()[0], Cycle<N>()));
+    assert(0 == table.attractor(0) && 0 == table.transient(0));
+
+    // Every state reaches its cycle after its transient, and is one generation further than its successor.
+    vector<Frame<N>> cycle_frames;
+    for (uint32_t state = 0; state < SuccessorTable<N>::StateCount; state += 7)
+    {
+        assert(table.attractor(state) == table.attractor(table.successor(state)));
+        if (table.transient(state) > 0)
+            assert(table.transient(state) == table.transient(table.successor(state)) + 1);
+
+        uint32_t reached = state;
+        for (uint16_t i = 0; i < table.transient(state); ++i)
+            reached = table.successor(reached);
+        assert(0 == table.transient(reached));
+
+        GameOfLife<N> game{ Frame<N>(state) };
+        assert(typename Cycle<N>::Equal()(game.find_cycle(cycle_frames), table.cycles()[table.attractor(state)]));
+    }
+}
+
+int main()
+{
+    assert_matches_enumeration<3>();
+    assert_matches_enumeration<4>();
+}
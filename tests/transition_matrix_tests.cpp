@@ -0,0 +1,132 @@
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <enumeration.hpp>
+#include <transition_matrix.hpp>
+
+using namespace std;
+
+/// @brief Every cycle of the 4x4 board, perturbations never leave it.
+CycleCatalogue<4> full_catalogue()
+{
+    ParallelEnumerator<4> enumerator;
+    const auto cycles = enumerator.enumerate(0, Frame<4>::States);
+
+    vector<Cycle<4>> sorted_cycles(cycles.begin(), cycles.end());
+    sort(sorted_cycles.begin(), sorted_cycles.end(), Cycle<4>::Less());
+    CycleCatalogue<4> catalogue(sorted_cycles.size());
+    for (const auto &cycle : sorted_cycles)
+        catalogue.insert(cycle);
+    return catalogue;
+}
+
+/// @brief Value of a token of the text format, an integer or a fraction.
+double parse_rate(const string &token)
+{
+    const auto slash = token.find('/');
+    if (string::npos == slash)
+        return stod(token);
+    return stod(token.substr(0, slash)) / stod(token.substr(slash + 1));
+}
+
+int main()
+{
+    const auto catalogue = full_catalogue();
+    const TransitionMatrix<4> matrix(catalogue, 3);
+    assert(matrix.rows() == catalogue.size());
+
+    // Every row counts the flips of every cell of every frame, minus T*N^2 on the diagonal.
+    for (uint32_t row = 0; row < matrix.rows(); ++row)
+    {
+        map<uint32_t, int64_t> expected { { row, -int64_t(catalogue.period(row) * Frame<4>::CellCount) } };
+        for (const auto &frame : catalogue.frames(row))
+            for (const auto &cycle : GameOfLife<4>::perturb_all(frame))
+                ++expected[catalogue.id(cycle)];
+
+        assert(matrix.period(row) == catalogue.period(row));
+        assert(matrix.columns(row).size() == expected.size());
+        size_t i = 0;
+        int64_t sum = 0;
+        for (const auto &[column, frequency] : expected)
+        {
+            assert(matrix.columns(row)[i] == column);
+            assert(matrix.frequencies(row)[i] == frequency);
+            sum += frequency;
+            ++i;
+        }
+        assert(0 == sum);
+    }
+
+    // The result does not depend on the thread count.
+    const TransitionMatrix<4> sequential(catalogue, 1);
+    assert(sequential.non_zeros() == matrix.non_zeros());
+    for (uint32_t row = 0; row < matrix.rows(); ++row)
+    {
+        assert(std::ranges::equal(sequential.columns(row), matrix.columns(row)));
+        assert(std::ranges::equal(sequential.frequencies(row), matrix.frequencies(row)));
+    }
+
+    // Rates of the sparse matrix and of the text format are frequency / period.
+    const auto sparse = matrix.sparse();
+    assert(sparse.nonZeros() == static_cast<Eigen::Index>(matrix.non_zeros()));
+    stringstream text;
+    matrix.write_text(text);
+    for (uint32_t row = 0; row < matrix.rows(); ++row)
+    {
+        vector<double> dense(matrix.rows(), 0.0);
+        for (size_t i = 0; i < matrix.columns(row).size(); ++i)
+            dense[matrix.columns(row)[i]] = double(matrix.frequencies(row)[i]) / matrix.period(row);
+
+        string line;
+        getline(text, line);
+        istringstream tokens(line);
+        vector<double> parsed;
+        for (string token; tokens >> token;)
+        {
+            if (token.starts_with("0$"))
+                parsed.resize(parsed.size() + stoul(token.substr(2)), 0.0);
+            else
+                parsed.push_back(parse_rate(token));
+        }
+
+        assert(parsed.size() == dense.size());
+        for (size_t column = 0; column < dense.size(); ++column)
+        {
+            assert(abs(parsed[column] - dense[column]) < 1e-12);
+            assert(abs(sparse.coeff(row, column) - dense[column]) < 1e-12);
+        }
+    }
+
+    // The binary form holds the CSR arrays after its header.
+    const auto path = filesystem::temp_directory_path() / "golc-transition-matrix-tests.bin";
+    matrix.write_binary(path);
+    {
+        auto is = checkpoint::open(path);
+        checkpoint::read_header(is, 0x4D4C4F47, 4); // "GOLM"
+        assert(checkpoint::read_value<uint64_t>(is) == matrix.rows());
+        assert(checkpoint::read_value<uint64_t>(is) == matrix.non_zeros());
+
+        uint64_t offset = 0;
+        for (size_t row = 0; row <= matrix.rows(); ++row)
+        {
+            assert(checkpoint::read_value<uint64_t>(is) == offset);
+            if (row < matrix.rows())
+                offset += matrix.columns(row).size();
+        }
+        for (size_t row = 0; row < matrix.rows(); ++row)
+            for (const auto column : matrix.columns(row))
+                assert(checkpoint::read_value<uint32_t>(is) == column);
+        for (size_t row = 0; row < matrix.rows(); ++row)
+            for (const auto frequency : matrix.frequencies(row))
+                assert(checkpoint::read_value<int64_t>(is) == frequency);
+        for (size_t row = 0; row < matrix.rows(); ++row)
+            assert(checkpoint::read_value<uint32_t>(is) == matrix.period(row));
+        assert(is.peek() == EOF);
+    }
+    filesystem::remove(path);
+}
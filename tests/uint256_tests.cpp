@@ -0,0 +1,122 @@
+#include <assert.h>
+#include <random>
+#include <sstream>
+#include <string>
+#include <uint256.hpp>
+
+using namespace std;
+
+/// @brief Value with the given bit set.
+uint256 bit(size_t index)
+{
+    return uint256(1) << index;
+}
+
+string decimal(const uint256 &value)
+{
+    ostringstream os;
+    os << value;
+    return os.str();
+}
+
+/// @brief Shift by every amount, the word loops have their own cases at multiples of 64.
+void assert_shifts(const uint256 &value)
+{
+    for (size_t amount = 0; amount < 260; ++amount)
+    {
+        const auto left = value << amount, right = value >> amount;
+        for (size_t index = 0; index < 256; ++index)
+        {
+            assert(bool(left & bit(index)) == (index >= amount && bool(value & bit(index - amount))));
+            assert(bool(right & bit(index)) == (index + amount < 256 && bool(value & bit(index + amount))));
+        }
+    }
+    assert(value << 0 == value && value >> 0 == value);
+    assert(0 == value << 256 && 0 == value >> 256 && 0 == value << 1000);
+}
+
+int main()
+{
+    const uint256 max = ~uint256(0);
+    mt19937_64 random(42);
+    const auto random_value = [&] { return uint256::from_words(random(), random(), random(), random()); };
+
+    // Negative values sign-extend, values from absl keep their high word.
+    assert(uint256(-1) == max);
+    assert(uint256(absl::MakeUint128(3, 5)) == uint256::from_words(5, 3, 0, 0));
+    assert(256 == max.popcount() && 0 == uint256().popcount());
+
+    assert_shifts(max);
+    assert_shifts(uint256(1));
+    assert_shifts(bit(63) | bit(64) | bit(127) | bit(128) | bit(255));
+    assert_shifts(random_value());
+    assert(bit(255) >> 255 == 1 && bit(64) == uint256::from_words(0, 1, 0, 0));
+
+    // Addition and subtraction carry across words and wrap modulo 2^256.
+    assert(uint256::from_words(~uint64_t(0), ~uint64_t(0), ~uint64_t(0), 0) + 1 == bit(192));
+    assert(max + 1 == 0 && uint256(0) - 1 == max);
+    assert(bit(192) - 1 == uint256::from_words(~uint64_t(0), ~uint64_t(0), ~uint64_t(0), 0));
+    uint256 counter = max;
+    assert(counter++ == max && 0 == counter);
+
+    // Products wrap modulo 2^256.
+    assert(bit(255) * 2 == 0);
+    assert(bit(128) * bit(127) == bit(255) && bit(128) * bit(128) == 0);
+    assert(max * max == 1);
+    assert(max * 3 == uint256(0) - 3);
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto a = random_value(), b = random_value(), c = random_value();
+        assert(a * b == b * a);
+        assert(a * (b + c) == a * b + a * c);
+        assert(a * max == uint256(0) - a);
+        assert(~a + 1 == uint256(0) - a);
+
+        // Products that fit 128 bits agree with absl.
+        const absl::uint128 x = absl::MakeUint128(random() >> 2, random()), y = random();
+        assert(uint256(x) * uint256(y) == (uint256(absl::Uint128High64(x) * absl::uint128(y)) << 64) + uint256(absl::Uint128Low64(x) * absl::uint128(y)));
+        assert(uint256(x * 3) == uint256(x) * 3);
+    }
+
+    // Division by a word is exact: quotient * divisor + remainder gives the dividend back.
+    for (const uint64_t divisor : { uint64_t(1), uint64_t(2), uint64_t(3), uint64_t(10'000'000'000'000'000'000ull), ~uint64_t(0) })
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            const auto value = 0 == i ? max : random_value();
+            const auto [quotient, remainder] = value.divide(divisor);
+            assert(remainder < divisor);
+            assert(quotient * divisor + remainder == value);
+            assert(value / divisor == quotient && value % divisor == remainder);
+        }
+    }
+    assert(max / 1 == max && 0 == max % 1);
+    assert(max / ~uint64_t(0) == uint256::from_words(1, 1, 1, 1) && 0 == max % ~uint64_t(0));
+    assert(uint256(5) / 7 == 0 && 5 == uint256(5) % 7);
+
+    // Ordering starts at the most significant word.
+    assert(bit(192) > uint256::from_words(~uint64_t(0), ~uint64_t(0), ~uint64_t(0), 0));
+    assert(uint256(1) < uint256(2) && bit(64) > uint256(~uint64_t(0)));
+
+    // Decimal output, including the zeros inside a 19 digit chunk.
+    assert("0" == decimal(0));
+    assert("18446744073709551615" == decimal(~uint64_t(0)));
+    assert("10000000000000000000" == decimal(10'000'000'000'000'000'000ull));
+    assert("1000000000000000000000000000000000000001" == decimal(uint256(10'000'000'000'000'000'000ull) * 10'000'000'000'000'000'000ull * 10 + 1));
+    assert("115792089237316195423570985008687907853269984665640564039457584007913129639935" == decimal(max));
+    for (int i = 0; i < 100; ++i)
+    {
+        const absl::uint128 value = absl::MakeUint128(random(), random());
+        ostringstream os;
+        os << value;
+        assert(os.str() == decimal(value));
+    }
+
+    // Constant evaluation takes the word loops instead of the vector instructions.
+    static_assert((uint256::from_words(1, 2, 3, 4) & uint256::from_words(3, 3, 3, 3)) == uint256::from_words(1, 2, 3, 0));
+    static_assert((~uint256(0) << 100 >> 100) == (~uint256(0) >> 100));
+    static_assert(~uint256(0) * ~uint256(0) == 1);
+    const auto a = random_value(), b = random_value();
+    assert(((a & b) | (a ^ b)) == (a | b));
+    assert((a ^ a) == 0 && (a | ~a) == max && (a & ~a) == 0);
+}
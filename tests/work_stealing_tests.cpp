@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <work_stealing.hpp>
+
+using namespace std;
+
+/// @brief Every task runs exactly once on a valid worker.
+void assert_runs_each_task_once(WorkStealingScheduler &scheduler, size_t task_count)
+{
+    vector<atomic<int>> runs(task_count);
+    atomic<bool> valid_workers = true;
+    scheduler.run(task_count, [&](size_t worker, size_t task)
+    {
+        if (worker >= scheduler.thread_count())
+            valid_workers = false;
+        ++runs[task];
+    });
+
+    assert(valid_workers);
+    for (const auto &count : runs)
+        assert(1 == count);
+}
+
+int main()
+{
+    WorkStealingScheduler scheduler(4);
+    assert(4 == scheduler.thread_count());
+
+    for (const size_t task_count : { 0, 1, 3, 4, 5, 1000 })
+        assert_runs_each_task_once(scheduler, task_count);
+
+    // Many short runs reuse the same workers.
+    for (int i = 0; i < 2000; ++i)
+        assert_runs_each_task_once(scheduler, i % 7);
+
+    // Uneven tasks get stolen by idle workers.
+    scheduler.run(64, [](size_t, size_t task)
+    {
+        if (task < 16)
+            this_thread::sleep_for(chrono::milliseconds(2));
+    });
+    assert(scheduler.steals() > 0);
+
+    // A task that throws ends the run with its exception, the scheduler keeps working.
+    bool thrown = false;
+    try
+    {
+        scheduler.run(100, [](size_t, size_t task)
+        {
+            if (42 == task)
+                throw runtime_error("task failed");
+        });
+    }
+    catch (const runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    assert_runs_each_task_once(scheduler, 100);
+
+    // Schedulers that are destroyed right away or never run shut down cleanly.
+    for (int i = 0; i < 50; ++i)
+    {
+        WorkStealingScheduler short_lived(3);
+        if (i % 2)
+            assert_runs_each_task_once(short_lived, 10);
+    }
+
+    WorkStealingScheduler single(1);
+    assert_runs_each_task_once(single, 10);
+    assert(0 == single.steals());
+}
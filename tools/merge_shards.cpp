@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <cycle_catalogue.hpp>
+#include <cycle_database.hpp>
+#include <shard.hpp>
+
+using namespace std;
+
+template<size_t Ts>
+void merge(const filesystem::path &output, const vector<filesystem::path> &inputs)
+{
+    size_t total = 0;
+    for (const auto &input : inputs)
+    {
+        const CycleDatabase<Ts> database(input);
+        cout << input.string() << ": " << database.size() << " cycles\n";
+        total += database.size();
+    }
+
+    const auto catalogue = merge_cycle_databases<Ts>(inputs);
+    write_cycle_database(output, catalogue);
+
+    cout << "Merged " << inputs.size() << " shards into " << output.string() << ": " << catalogue.size()
+         << " cycles, " << total - catalogue.size() << " duplicates dropped\n";
+}
+
+template<size_t... Sizes>
+bool merge_for_size(uint32_t board_size, const filesystem::path &output, const vector<filesystem::path> &inputs, index_sequence<Sizes...>)
+{
+    // Board sizes start at 3, smaller tori have no interesting cycles.
+    return ((board_size == Sizes + 3 && (merge<Sizes + 3>(output, inputs), true)) || ...);
+}
+
+/// @brief Combines the cycle databases written by GoLC --shard i/k into one database with global ids.
+/// The ids follow the canonical frame order, so merging the shards of any split gives the same file.
+/// Usage: GoLCMergeShards output.db shard.db...
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        cerr << "Usage: " << argv[0] << " output.db shard.db...\n";
+        return 2;
+    }
+
+    const filesystem::path output = argv[1];
+    const vector<filesystem::path> inputs(argv + 2, argv + argc);
+
+    try
+    {
+        const uint32_t board_size = cycle_database::board_size(inputs.front());
+        if (!merge_for_size(board_size, output, inputs, make_index_sequence<14>()))
+        {
+            cerr << "Unsupported board size: " << board_size << '\n';
+            return 1;
+        }
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}